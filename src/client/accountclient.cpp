@@ -7,6 +7,8 @@ AccountClient::AccountClient(net::Client& client):
 {
     loggedIn = false;
     packetReceived = false;
+    queuePosition = 0;
+    queueUpdated = false;
     auto accountPacketHandler = [&](sf::Packet& packet)
     {
         packet >> status;
@@ -14,7 +16,16 @@ AccountClient::AccountClient(net::Client& client):
     };
     client.registerCallback(Packet::LogInStatus, accountPacketHandler);
     client.registerCallback(Packet::CreateAccountStatus, accountPacketHandler);
-    client.setGroup("login", {Packet::LogInStatus});
+    client.registerCallback(Packet::LogInQueue, [&](sf::Packet& packet)
+    {
+        sf::Uint32 position = 0;
+        if (packet >> position)
+        {
+            queuePosition = position;
+            queueUpdated = true;
+        }
+    });
+    client.setGroup("login", {Packet::LogInStatus, Packet::LogInQueue});
     client.setGroup("createAccount", {Packet::CreateAccountStatus});
 }
 
@@ -38,10 +49,19 @@ int AccountClient::logIn(const net::Address& address, const std::string& usernam
         // Wait until you get a response from the server for your log in request
         // TODO: Move this outside of this function and have a function for polling if it was successful.
         packetReceived = false;
+        queuePosition = 0;
+        queueUpdated = false;
         sf::Clock loginTimer;
         while (!packetReceived && loginTimer.getElapsedTime().asSeconds() < timeout)
         {
             client.receive("login");
+            // The server is still there while it keeps sending queue positions, so keep waiting
+            if (queueUpdated)
+            {
+                std::cout << "Position in the login queue: " << queuePosition << std::endl;
+                loginTimer.restart();
+                queueUpdated = false;
+            }
             sf::sleep(sf::milliseconds(10));
         }
 
@@ -24,6 +24,8 @@ class AccountClient
         bool loggedIn;
         int status;
         bool packetReceived;
+        unsigned queuePosition; // Where this client is in the server's login queue (0 if it isn't in one)
+        bool queueUpdated;
 };
 
 #endif
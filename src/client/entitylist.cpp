@@ -3,55 +3,63 @@
 
 #include "entitylist.h"
 #include <iostream>
-#include "entityalloc.h"
+#include "packet.h"
 
 EntityList::EntityList()
 {
 }
 
-void EntityList::updateEntity(EID id, sf::Packet& packet)
+EntityList::~EntityList()
 {
-    Entity* ent = find(id);
-    EType type;
-    packet >> type;
-    if (ent == nullptr) // If the entity does not exist already
-        ent = add(type, id); // Add a new default entity of that type to the list with that ID
+    for (auto& ent: ents)
+        allocator.free(ent.second);
+}
 
-    if (ent != nullptr) // If the entity exists
+bool EntityList::updateEntity(EID id, sf::Packet& packet)
+{
+    sf::Uint8 header = 0;
+    packet >> header;
+    if (header & Packet::EntityCode::Removed) // The entity was deleted or went out of range of this client
     {
-        // TODO: We should find a better way to destroy entities on the client...
-        // It would be best if each client could keep track of it to lessen the load on the server.
-        // Maybe some kind of timeout or out of range of the client's entity area.
-        if (type == -1)
-        {
+        sf::Uint8 reason = 0;
+        packet >> reason;
+        if (find(id) != nullptr)
             erase(id); // Delete the entity
-            std::cout << "Deleted entity " << id << std::endl;
-        }
-        else
+        return true;
+    }
+
+    Entity* ent = find(id);
+    if (header & Packet::EntityCode::Created)
+    {
+        sf::Uint8 type = 0;
+        packet >> type;
+        if (ent != nullptr && ent->getType() != type)
         {
-            if (ent->getType() == type)
-            {
-                ent->setData(packet); // Update the entity with data from the packet
-                //cout << "Set entity " << ent->getID() << " with data from packet.\n";
-            }
-            else
-            {
-                //cout << "ERROR: Non-matching entity type update received!\n";
-                // Recreate the entity with a new type
-                erase(id);
-                add(type, id);
-                std::cout << "Recreated entity " << id << " with type " << type << std::endl;
-            }
+            // The ID is being used for a different type of entity now, so recreate it
+            erase(id);
+            ent = nullptr;
+            std::cout << "Recreated entity " << id << " with type " << (int)type << std::endl;
         }
+        if (ent == nullptr) // If the entity does not exist already
+            ent = add(type, id); // Add a new default entity of that type to the list with that ID
     }
+
+    if (ent != nullptr) // If the entity exists
+        ent->setData(packet, header & Entity::AllFields); // Update the entity with data from the packet
     else
-        std::cerr << "ERROR: Problem allocating new entity in updateEntity()!\n";
+    {
+        // The rest of the packet can't be read without knowing the type of this entity
+        std::cerr << "ERROR: Received an update for unknown entity " << id << " in updateEntity()!\n";
+        packet.clear();
+        return false;
+    }
+    return true;
 }
 
 // This function allocates a new entity based on type AND inserts it into the entity list
 Entity* EntityList::add(EType type, EID id)
 {
-    return insert(allocateEntity(type), id);
+    return insert(allocator.allocate(type), id);
 }
 
 Entity* EntityList::insert(Entity* newEnt, EID id)
@@ -75,14 +83,14 @@ Entity* EntityList::find(EID id)
 
 void EntityList::erase(EID id)
 {
-    delete ents[id]; // Deallocate
+    allocator.free(ents[id]); // Deallocate
     ents.erase(id); // Remove the pointer
 }
 
 void EntityList::clear()
 {
     for (auto& ent: ents) // Go through the entities
-        delete ent.second; // Deallocate them
+        allocator.free(ent.second); // Deallocate them
     ents.clear(); // Remove all pointers
     std::cout << "Cleared entity list.\n";
 }
@@ -93,8 +101,17 @@ void EntityList::update(float time)
         ent.second->update(time);
 }
 
-void EntityList::draw(sf::RenderTarget& window, sf::RenderStates states) const
+unsigned EntityList::size() const
 {
-    for (auto& ent: ents)
-        window.draw(*(ent.second), states);
+    return ents.size();
+}
+
+EntityList::EntityMap::const_iterator EntityList::begin() const
+{
+    return ents.begin();
+}
+
+EntityList::EntityMap::const_iterator EntityList::end() const
+{
+    return ents.end();
 }
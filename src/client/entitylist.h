@@ -8,10 +8,12 @@ EntityList class:
     Will have a std::map<EID,Entity*> for its main data structure.
 Purpose:
     Manages the client's main entity list, which stores all of the entity pointers.
-    Also manages dynamic memory allocation
+    Also manages dynamic memory allocation (the entities come from pools in an EntityAllocator)
 The client will only need to instantiate 1 EntityList object, which can hold everything the server sends to it.
     This is much simpler than having a mini grid or something, but will still be efficient,
     and that will be the only thing the client will have to do (rather than process an entire grid).
+The server only sends the entities that are close to the client's player, and tells the client when
+    entities are deleted or go out of range, so they get removed from this list.
 */
 
 #ifndef ENTITYLIST_H
@@ -19,22 +21,29 @@ The client will only need to instantiate 1 EntityList object, which can hold eve
 
 #include <map>
 #include "entity.h"
+#include "entityalloc.h"
 
-class EntityList: public sf::Drawable
+class EntityList
 {
     public:
+        using EntityMap = std::map<EID,Entity*>;
+
         EntityList();
-        void updateEntity(EID, sf::Packet&);
+        ~EntityList();
+        bool updateEntity(EID, sf::Packet&); // Returns false if the update could not be applied
         Entity* add(EType, EID);
-        Entity* insert(Entity*, EID);
+        Entity* insert(Entity*, EID); // The entity must have been allocated by this list
         Entity* find(EID);
         void erase(EID);
         void clear();
         void update(float);
-        void draw(sf::RenderTarget&, sf::RenderStates) const;
+        unsigned size() const;
+        EntityMap::const_iterator begin() const;
+        EntityMap::const_iterator end() const;
 
     private:
-        std::map<EID,Entity*> ents; // stores entity pointers, accessed by searching for ID
+        EntityMap ents; // stores entity pointers, accessed by searching for ID
+        EntityAllocator allocator; // all of the entities are allocated from here
 };
 
 #endif
@@ -4,6 +4,7 @@
 #include "gamestate.h"
 #include <string>
 #include "packet.h"
+#include "packetcodec.h"
 #include "tile.h"
 #include "takescreenshot.h"
 #include "paths.h"
@@ -14,13 +15,14 @@
 
 GameState::GameState(GameObjects& gameObjects):
     CommonState(gameObjects),
+    tileMapRenderer(tileMap),
     sysManager(objManager, msgHub)
 {
     loadHotkeys();
 
     // Load textures
-    Tile::loadTextures();
-    Entity::loadTextures();
+    tileMapRenderer.loadTextures();
+    entityRenderer.loadTextures();
 
     myPlayer = nullptr;
     myPlayerId = 0;
@@ -181,10 +183,11 @@ void GameState::draw()
     objects.window.setView(gameView);
 
 	// Draw the tile map
-    objects.window.draw(tileMap);
+    objects.window.draw(tileMapRenderer);
 
     // Draws all of the entities
-    objects.window.draw(entList);
+    for (auto& ent: entList)
+        entityRenderer.draw(objects.window, *(ent.second));
 
     // Draw the HUD (changes the window's view)
     objects.window.draw(theHud);
@@ -363,15 +366,26 @@ void GameState::sendAngleInputPacket()
 
 void GameState::processEntityPacket(sf::Packet& packet)
 {
-    EID entId;
+    sf::Uint32 sequence = 0;
+    if (!(packet >> sequence))
+        return;
+    sf::Uint32 entId;
     int count = 0;
-    while (packet >> entId)
+    bool applied = true;
+    while (PacketCodec::readVarInt(packet, entId))
     {
-        entList.updateEntity(entId, packet);
+        applied = (entList.updateEntity(entId, packet) && applied);
         ++count;
     }
     if (count >= 10)
         std::cout << "Updated " << count << " entities from server.\n";
+    // Let the server know this update was applied, so it can send the next ones relative to it
+    if (applied)
+    {
+        sf::Packet ackPacket;
+        ackPacket << Packet::SnapshotAck << sequence;
+        objects.client.send(ackPacket);
+    }
     if (myPlayer == nullptr)
         myPlayer = entList.find(myPlayerId);
 }
@@ -11,6 +11,8 @@
 #include "hud.h"
 #include "mainmenustate.h"
 #include "tilemap.h"
+#include "tilemaprenderer.h"
+#include "entityrenderer.h"
 #include "gamehotkeys.h"
 #include "OCS/Objects/ObjectManager.hpp"
 #include "OCS/Messaging/MessageHub.hpp"
@@ -51,7 +53,9 @@ class GameState: public CommonState
 
         // Important objects
         TileMap tileMap;
+        TileMapRenderer tileMapRenderer;
         EntityList entList;
+        EntityRenderer entityRenderer; // The entities don't have any graphics, so they are drawn with this
         Entity* myPlayer;
         Hud theHud; // TODO: Choose a better name?
         GameHotkeys hotkeys;
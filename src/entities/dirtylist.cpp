@@ -0,0 +1,68 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "dirtylist.h"
+#include "entity.h"
+
+DirtyList::DirtyList():
+    head(nullptr),
+    count(0)
+{
+}
+
+DirtyList::~DirtyList()
+{
+    clear();
+}
+
+void DirtyList::push(Entity* ent)
+{
+    if (ent == nullptr || ent->dirtyLinked)
+        return;
+    ent->prevDirty = nullptr;
+    ent->nextDirty = head;
+    if (head != nullptr)
+        head->prevDirty = ent;
+    head = ent;
+    ent->dirtyLinked = true;
+    ++count;
+}
+
+void DirtyList::remove(Entity* ent)
+{
+    if (ent == nullptr || !ent->dirtyLinked || ent->dirtyList != this)
+        return;
+    if (ent->prevDirty != nullptr)
+        ent->prevDirty->nextDirty = ent->nextDirty;
+    else
+        head = ent->nextDirty;
+    if (ent->nextDirty != nullptr)
+        ent->nextDirty->prevDirty = ent->prevDirty;
+    ent->prevDirty = nullptr;
+    ent->nextDirty = nullptr;
+    ent->dirtyLinked = false;
+    --count;
+}
+
+Entity* DirtyList::pop()
+{
+    Entity* ent = head;
+    remove(ent);
+    return ent;
+}
+
+void DirtyList::clear()
+{
+    while (head != nullptr)
+        pop();
+}
+
+bool DirtyList::empty() const
+{
+    return (head == nullptr);
+}
+
+unsigned DirtyList::size() const
+{
+    return count;
+}
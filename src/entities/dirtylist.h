@@ -0,0 +1,33 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef DIRTYLIST_H
+#define DIRTYLIST_H
+
+class Entity;
+
+/*
+This class is an intrusive list of the entities that have changed, so they can be found without looking at every entity.
+The links are stored in the entities themselves, so adding and removing never allocates anything,
+    and an entity can be removed from the middle of the list right away (like when it gets deleted).
+An entity that is attached to this adds itself when one of its fields changes, and can only be in the list once.
+This is only used on the server.
+*/
+class DirtyList
+{
+    public:
+        DirtyList();
+        ~DirtyList();
+        void push(Entity*); // Adds an entity to the front, does nothing if it's already in a list
+        void remove(Entity*); // Removes an entity if it's in this list
+        Entity* pop(); // Removes and returns the front entity, returns null if the list is empty
+        void clear();
+        bool empty() const;
+        unsigned size() const;
+
+    private:
+        Entity* head;
+        unsigned count;
+};
+
+#endif
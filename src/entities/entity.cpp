@@ -2,23 +2,29 @@
 // See the file LICENSE.txt for copying conditions.
 
 #include "entity.h"
-#include "paths.h"
+#include "packetcodec.h"
+#include "movementarrays.h"
+#include "dirtylist.h"
 
 int Entity::mapWidth = 0;
 int Entity::mapHeight = 0;
 
-TileSet Entity::textures;
-
 Entity::Entity()
 {
     type = Invalid;
     id = -1;
     ready = false;
-    changed = true;
+    changedFields = AllFields;
+    movement = nullptr;
+    dirtyList = nullptr;
+    prevDirty = nullptr;
+    nextDirty = nullptr;
+    dirtyLinked = false;
 }
 
 Entity::~Entity()
 {
+    attachDirtyList(nullptr);
 }
 
 const EID Entity::getID() const
@@ -58,12 +64,45 @@ bool Entity::getReady() const
 
 void Entity::setChanged(bool state)
 {
-    changed = state;
+    if (state)
+        markChanged(AllFields);
+    else
+        changedFields = 0; // If it's in the dirty list, it will just be skipped
+}
+
+void Entity::markChanged(sf::Uint8 fields)
+{
+    changedFields |= fields;
+    if (changedFields != 0 && dirtyList != nullptr)
+        dirtyList->push(this);
 }
 
 bool Entity::hasChanged() const
 {
-    return changed;
+    return (changedFields != 0);
+}
+
+sf::Uint8 Entity::getChangedFields() const
+{
+    return changedFields;
+}
+
+void Entity::getData(sf::Packet& packet, sf::Uint8 fields)
+{
+    if (fields & Position)
+    {
+        PacketCodec::writePosition(packet, pos.x);
+        PacketCodec::writePosition(packet, pos.y);
+    }
+}
+
+void Entity::setData(sf::Packet& packet, sf::Uint8 fields)
+{
+    if (fields & Position)
+    {
+        PacketCodec::readPosition(packet, pos.x);
+        PacketCodec::readPosition(packet, pos.y);
+    }
 }
 
 float Entity::getVisualAngle() const
@@ -74,8 +113,8 @@ float Entity::getVisualAngle() const
 void Entity::setPos(const sf::Vector2f& position)
 {
     pos = position;
-    sprite.setPosition(pos);
-    changed = true;
+    markChanged(Position);
+    syncMovement();
 }
 
 const sf::Vector2f& Entity::getPos() const
@@ -88,28 +127,38 @@ void Entity::moveTo(const sf::Vector2f& posToMove)
     setPos(posToMove);
 }
 
-int Entity::getItem() const
+void Entity::attachMovement(MovementArrays* arrays)
 {
-    return -1;
+    movement = arrays;
+    syncMovement();
 }
 
-void Entity::setMapSize(int width, int height)
+void Entity::attachDirtyList(DirtyList* list)
 {
-    mapWidth = width;
-    mapHeight = height;
+    if (dirtyList != nullptr)
+        dirtyList->remove(this);
+    dirtyList = list;
+    markChanged(0); // Adds it to the new list if it has changes already
 }
 
-void Entity::loadTextures()
+void Entity::syncMovement()
 {
-    if (!textures.isLoaded())
-    {
-        textures.setTileSize(64, 64);
-        textures.loadImage(Paths::entitiesImage, true);
-    }
+    if (movement != nullptr)
+        movement->set(EntityId::getIndex(id), pos, sf::Vector2f(), 0, false);
+}
+
+void Entity::applyMovement(const sf::Vector2f& position, int)
+{
+    pos = position;
 }
 
-void Entity::setTexture(unsigned int textureId)
+int Entity::getItem() const
 {
-    if (textureId < textures.size())
-        sprite.setTexture(textures[textureId]);
+    return -1;
+}
+
+void Entity::setMapSize(int width, int height)
+{
+    mapWidth = width;
+    mapHeight = height;
 }
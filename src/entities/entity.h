@@ -4,16 +4,19 @@
 #ifndef ENTITY_H
 #define ENTITY_H
 
-#include <SFML/Graphics.hpp>
+#include <SFML/System.hpp>
 #include <SFML/Network.hpp>
-#include "../graphics/tileset.h"
+#include "entityid.h"
 
-typedef sf::Int32 EID;
 typedef sf::Int32 EType;
 
+class MovementArrays;
+class DirtyList;
+
 // TODO: Redesign this class as well as the whole inheritance tree
+// Entities only have game state, they are drawn on the client by an EntityRenderer
 
-class Entity: public sf::Drawable
+class Entity
 {
     public:
         Entity();
@@ -25,7 +28,6 @@ class Entity: public sf::Drawable
         // These are the functions that all entities will have (Which need to be defined by classes which inherit from Entity)
         virtual void update(float) = 0;
         virtual bool collides(Entity*);
-        virtual void draw(sf::RenderTarget&, sf::RenderStates) const = 0;
 
         // This will be great for optimizing stuff, and doubly acts as a way to separate dynamic/static entities!
         // It also can be false even with dynamic entities.
@@ -37,14 +39,17 @@ class Entity: public sf::Drawable
         bool getReady() const;
 
         // For setting/getting if the entity state has changed
-        void setChanged(bool);
+        void setChanged(bool); // Sets or clears all of the fields
+        void markChanged(sf::Uint8); // Adds to the changed fields (and to the attached dirty list)
         bool hasChanged() const;
+        sf::Uint8 getChangedFields() const;
 
-        virtual void getData(sf::Packet&) = 0; // get data from entity into a packet
-        virtual void setData(sf::Packet&) = 0; // set data from a packet into entity
+        // Only the fields passed in are written/read, in the same order as the Field flags
+        virtual void getData(sf::Packet&, sf::Uint8); // get data from entity into a packet
+        virtual void setData(sf::Packet&, sf::Uint8); // set data from a packet into entity
 
         virtual void setAngle(float) {}
-        virtual float getVisualAngle() const;
+        virtual float getVisualAngle() const; // The angle the entity is facing, used for drawing
         virtual void setVisualAngle(float) {}
         virtual void setSpeed(float) {}
         virtual void setMoving(bool) {}
@@ -52,6 +57,12 @@ class Entity: public sf::Drawable
         const sf::Vector2f& getPos() const;
         virtual void moveTo(const sf::Vector2f&);
 
+        // For moving the entities in bulk on the server
+        void attachMovement(MovementArrays*); // The entity's ID must be set first
+        void attachDirtyList(DirtyList*); // The entity will add itself to this list when it changes (null to detach)
+        virtual void syncMovement(); // Writes the movement state into the attached arrays
+        virtual void applyMovement(const sf::Vector2f&, int); // Sets the integrated position, and how many map edges were hit
+
         // Item stuff
         virtual void attachItem(int) {};
         virtual int getItem() const;
@@ -59,7 +70,6 @@ class Entity: public sf::Drawable
         virtual void useItem() {};
 
         static void setMapSize(int, int);
-        static void loadTextures();
 
         // All of the different entity types
         enum Type
@@ -70,25 +80,42 @@ class Entity: public sf::Drawable
             Item
         };
 
-    protected:
-        void setTexture(unsigned int);
-
-        static TileSet textures;
+        // All of the different fields that can be sent, used as bit flags
+        enum Field
+        {
+            Position = 1,
+            Angle = 2,
+            Speed = 4,
+            Moving = 8,
+            Health = 16,
+            VisualAngle = 32,
+            AllFields = 63
+        };
+        static const int fieldCount = 6;
 
+    protected:
         // We could also have a mutex for use with threads, but this is good for determining
-        // whether the entity is fully initialized and its textures are all set and stuff
+        // whether the entity is fully initialized
         bool ready;
-        bool changed;
+        sf::Uint8 changedFields; // The fields that need to be sent
+        MovementArrays* movement; // Where the movement state goes, null if not attached
         // Contains the entity's unique ID
         EID id;
         // Represents what type the entity is
         EType type;
         sf::Vector2f pos;
-        sf::Sprite sprite;
 
         static int mapWidth;
         static int mapHeight;
 
+    private:
+        friend class DirtyList;
+
+        // The links for the dirty list
+        DirtyList* dirtyList;
+        Entity* prevDirty;
+        Entity* nextDirty;
+        bool dirtyLinked;
 };
 
 #endif
@@ -2,22 +2,93 @@
 // See the file LICENSE.txt for copying conditions.
 
 #include "entityalloc.h"
-#include "player.h"
-#include "zombie.h"
-#include "itementity.h"
+#include <ostream>
 
-// This function allocates a new specific entity object from a type and returns its pointer
-Entity* allocateEntity(int type)
+Entity* EntityAllocator::allocate(int type)
 {
     switch (type)
     {
         case Entity::Player:
-            return new PlayerEntity();
+            return players.create();
         case Entity::Zombie:
-            return new Zombie();
+            return zombies.create();
         case Entity::Item:
-            return new ItemEntity();
+            return items.create();
         default:
             return nullptr;
     }
 }
+
+void EntityAllocator::free(Entity* ent)
+{
+    if (ent == nullptr)
+        return;
+    switch (ent->getType())
+    {
+        case Entity::Player:
+            players.destroy(static_cast<PlayerEntity*>(ent));
+            break;
+        case Entity::Zombie:
+            zombies.destroy(static_cast<Zombie*>(ent));
+            break;
+        case Entity::Item:
+            items.destroy(static_cast<ItemEntity*>(ent));
+            break;
+        default:
+            break;
+    }
+}
+
+void EntityAllocator::release(Entity* ent)
+{
+    if (ent == nullptr)
+        return;
+    switch (ent->getType())
+    {
+        case Entity::Player:
+            players.release(static_cast<PlayerEntity*>(ent));
+            break;
+        case Entity::Zombie:
+            zombies.release(static_cast<Zombie*>(ent));
+            break;
+        case Entity::Item:
+            items.release(static_cast<ItemEntity*>(ent));
+            break;
+        default:
+            break;
+    }
+}
+
+void EntityAllocator::releasePending()
+{
+    players.releasePending();
+    zombies.releasePending();
+    items.releasePending();
+}
+
+PoolStats EntityAllocator::getStats(int type) const
+{
+    switch (type)
+    {
+        case Entity::Player:
+            return players.getStats();
+        case Entity::Zombie:
+            return zombies.getStats();
+        case Entity::Item:
+            return items.getStats();
+        default:
+            return PoolStats();
+    }
+}
+
+void EntityAllocator::printStats(std::ostream& out) const
+{
+    const char* names[] = {"Players", "Zombies", "Items"};
+    out << "Entity pools:\n";
+    for (int type = Entity::Player; type <= Entity::Item; ++type)
+    {
+        PoolStats stats = getStats(type);
+        out << "    " << names[type] << ": " << stats.used << " used (" << stats.pending << " pending) of "
+            << stats.capacity << " in " << stats.slabs << " slabs\n";
+    }
+}
@@ -4,9 +4,32 @@
 #ifndef ENTITYALLOC_H
 #define ENTITYALLOC_H
 
+#include <iosfwd>
 #include "entity.h"
+#include "objectpool.h"
+#include "player.h"
+#include "zombie.h"
+#include "itementity.h"
 
-// Factory function for allocating new entities
-Entity* allocateEntity(int);
+/*
+This class is the factory for allocating new entities.
+Each type of entity has its own object pool, so entities don't get allocated one at a time on the heap.
+Entities from this must be freed with the same allocator.
+*/
+class EntityAllocator
+{
+    public:
+        Entity* allocate(int); // Allocates a new specific entity object from a type
+        void free(Entity*); // Destroys an entity right away
+        void release(Entity*); // Destroys an entity on the next call to releasePending
+        void releasePending();
+        PoolStats getStats(int) const; // Returns the occupancy of the pool for a type
+        void printStats(std::ostream&) const;
+
+    private:
+        ObjectPool<PlayerEntity> players;
+        ObjectPool<Zombie> zombies;
+        ObjectPool<ItemEntity> items;
+};
 
 #endif
@@ -0,0 +1,40 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef ENTITYID_H
+#define ENTITYID_H
+
+#include <SFML/System.hpp>
+
+typedef sf::Int32 EID;
+
+/*
+Entity IDs are generational handles: the low bits are a generation number, and the rest is an index.
+    The index is the slot the entity is stored in on the server, which gets reused after the entity is deleted.
+    The generation goes up every time the slot is reused, so old IDs that are still stored somewhere
+        (like in a player's data or a packet that was in flight) won't find the new entity.
+The client only uses the whole ID, it never needs to split it.
+*/
+namespace EntityId
+{
+    const int generationBits = 8;
+    const int generationMask = (1 << generationBits) - 1;
+    const int maxIndex = (1 << (31 - generationBits)) - 1;
+
+    inline EID make(int index, int generation)
+    {
+        return (index << generationBits) | (generation & generationMask);
+    }
+
+    inline int getIndex(EID id)
+    {
+        return (id >> generationBits);
+    }
+
+    inline int getGeneration(EID id)
+    {
+        return (id & generationMask);
+    }
+}
+
+#endif
@@ -3,7 +3,6 @@
 ItemEntity::ItemEntity()
 {
     type = Entity::Item;
-    setTexture(type);
 }
 
 void ItemEntity::update(float time)
@@ -15,18 +14,3 @@ bool ItemEntity::collides(Entity* ent)
 {
     return false;
 }
-
-void ItemEntity::draw(sf::RenderTarget& window, sf::RenderStates states) const
-{
-    window.draw(sprite);
-}
-
-void ItemEntity::getData(sf::Packet&)
-{
-
-}
-
-void ItemEntity::setData(sf::Packet&)
-{
-
-}
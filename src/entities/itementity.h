@@ -9,9 +9,6 @@ class ItemEntity: public Entity
         ItemEntity();
         void update(float);
         bool collides(Entity*);
-        void draw(sf::RenderTarget&, sf::RenderStates) const;
-        void getData(sf::Packet&);
-        void setData(sf::Packet&);
 
     private:
         // int itemId; // This should be in the base class
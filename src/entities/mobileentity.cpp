@@ -2,27 +2,25 @@
 // See the file LICENSE.txt for copying conditions.
 
 #include "mobileentity.h"
+#include <cmath>
+#include "packetcodec.h"
+#include "movementarrays.h"
 
 MobileEntity::MobileEntity()
 {
     angle = 0;
+    updateDirection();
     speed = defaultSpeed;
-    sprite.setOrigin(32, 32);
-    sprite.setPosition(400, 300);
     moving = false;
+    currentHealth = defaultHealth;
+    baseHealth = defaultHealth;
 }
 
 void MobileEntity::move(float deltaTime)
 {
     if (moving)
     {
-        float rad = (angle * PI) / 180.0;
-        sf::Vector2f amount;
-        amount.x = deltaTime * speed * cos(rad);
-        amount.y = deltaTime * speed * sin(rad);
-        sprite.move(amount);
-        updateSpriteRotation();
-        pos = sprite.getPosition();
+        pos += direction * (deltaTime * speed);
         handleCollision();
     }
 }
@@ -30,24 +28,79 @@ void MobileEntity::move(float deltaTime)
 void MobileEntity::setAngle(float deg)
 {
     angle = deg;
-    changed = true;
+    updateDirection();
+    markChanged(Angle | Position); // The position is sent too so the client starts turning from the right place
+    syncMovement();
 }
 
 void MobileEntity::setSpeed(float theSpeed)
 {
     speed = theSpeed;
-    changed = true;
+    markChanged(Speed | Position);
+    syncMovement();
 }
 
 void MobileEntity::setMoving(bool isMoving)
 {
     moving = isMoving;
-    changed = true;
+    markChanged(Moving | Position);
+    syncMovement();
 }
 
-void MobileEntity::updateSpriteRotation()
+float MobileEntity::getVisualAngle() const
 {
-    sprite.setRotation(angle + 90);
+    return angle;
+}
+
+void MobileEntity::getData(sf::Packet& packet, sf::Uint8 fields)
+{
+    Entity::getData(packet, fields);
+    if (fields & Angle)
+        PacketCodec::writeAngle(packet, angle);
+    if (fields & Speed)
+        PacketCodec::writeVarInt(packet, speed > 0 ? static_cast<sf::Uint32>(speed + 0.5f) : 0);
+    if (fields & Moving)
+        packet << moving;
+    if (fields & Health)
+    {
+        PacketCodec::writeVarInt(packet, currentHealth > 0 ? currentHealth : 0);
+        PacketCodec::writeVarInt(packet, baseHealth > 0 ? baseHealth : 0);
+    }
+}
+
+void MobileEntity::setData(sf::Packet& packet, sf::Uint8 fields)
+{
+    Entity::setData(packet, fields);
+    if (fields & Angle)
+    {
+        PacketCodec::readAngle(packet, angle);
+        updateDirection();
+    }
+    sf::Uint32 value = 0;
+    if ((fields & Speed) && PacketCodec::readVarInt(packet, value))
+        speed = value;
+    if (fields & Moving)
+        packet >> moving;
+    if ((fields & Health) && PacketCodec::readVarInt(packet, value))
+    {
+        currentHealth = value;
+        if (PacketCodec::readVarInt(packet, value))
+            baseHealth = value;
+    }
+}
+
+void MobileEntity::syncMovement()
+{
+    if (movement != nullptr)
+        movement->set(EntityId::getIndex(id), pos, direction, speed, moving);
+}
+
+void MobileEntity::applyMovement(const sf::Vector2f& position, int edgeHits)
+{
+    // The position was already clamped to the map, so only the angle needs to change
+    Entity::applyMovement(position, edgeHits);
+    for (int i = 0; i < edgeHits; ++i)
+        flipAngle();
 }
 
 void MobileEntity::handleCollision()
@@ -76,17 +129,24 @@ void MobileEntity::handleCollision()
         pos.y = mapHeight;
         flipAngle();
     }
-
-    sprite.setPosition(pos);
 }
 
 void MobileEntity::flipAngle()
 {
     if (type == Zombie)
     {
-        changed = true;
+        markChanged(Angle | Position);
         angle += 90;
         if (angle > 360)
             angle -= 360;
+        updateDirection();
+        syncMovement();
     }
 }
+
+void MobileEntity::updateDirection()
+{
+    float rad = (angle * PI) / 180.0;
+    direction.x = cos(rad);
+    direction.y = sin(rad);
+}
@@ -16,15 +16,22 @@ class MobileEntity: public Entity
         void setAngle(float);
         void setSpeed(float);
         void setMoving(bool);
-        virtual void updateSpriteRotation();
+        virtual float getVisualAngle() const;
+        virtual void getData(sf::Packet&, sf::Uint8);
+        virtual void setData(sf::Packet&, sf::Uint8);
+        void syncMovement();
+        void applyMovement(const sf::Vector2f&, int);
 
     protected:
         void handleCollision();
         void flipAngle();
+        void updateDirection(); // Call this after changing the angle
 
         static const int defaultSpeed = 10;
+        static const int defaultHealth = 100;
 
         float angle; // in degrees
+        sf::Vector2f direction; // unit vector of the angle, so it doesn't need to be calculated every frame
         float speed; // in pixels per second
         bool moving;
 
@@ -0,0 +1,109 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "movementarrays.h"
+#include <algorithm>
+
+// The arrays never overlap, and the compiler needs to know that (with __restrict) before it will vectorize this
+static void integrateArrays(unsigned count, float deltaTime, float maxX, float maxY, float* __restrict x, float* __restrict y,
+    const float* __restrict dx, const float* __restrict dy, const float* __restrict speed, const float* __restrict move,
+    sf::Uint8* __restrict hits)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        float step = deltaTime * speed[i] * move[i];
+        float newX = x[i] + step * dx[i];
+        float newY = y[i] + step * dy[i];
+        hits[i] = (newX < 0) + (newY < 0) + (newX >= maxX) + (newY >= maxY);
+        x[i] = std::min(std::max(newX, 0.0f), maxX);
+        y[i] = std::min(std::max(newY, 0.0f), maxY);
+    }
+}
+
+MovementArrays::MovementArrays():
+    width(0),
+    height(0)
+{
+}
+
+void MovementArrays::setBounds(float newWidth, float newHeight)
+{
+    width = newWidth;
+    height = newHeight;
+}
+
+void MovementArrays::clear()
+{
+    posX.clear();
+    posY.clear();
+    dirX.clear();
+    dirY.clear();
+    speeds.clear();
+    moving.clear();
+    edgeHits.clear();
+}
+
+unsigned MovementArrays::size() const
+{
+    return posX.size();
+}
+
+void MovementArrays::set(int index, const sf::Vector2f& pos, const sf::Vector2f& dir, float speed, bool isMoving)
+{
+    if (index < 0)
+        return;
+    if (index >= (int)posX.size())
+        resize(index + 1);
+    posX[index] = pos.x;
+    posY[index] = pos.y;
+    dirX[index] = dir.x;
+    dirY[index] = dir.y;
+    speeds[index] = speed;
+    moving[index] = (isMoving ? 1.0f : 0.0f);
+}
+
+void MovementArrays::remove(int index)
+{
+    if (index >= 0 && index < (int)moving.size())
+        moving[index] = 0;
+}
+
+void MovementArrays::resize(unsigned count)
+{
+    posX.resize(count, 0);
+    posY.resize(count, 0);
+    dirX.resize(count, 0);
+    dirY.resize(count, 0);
+    speeds.resize(count, 0);
+    moving.resize(count, 0);
+    edgeHits.resize(count, 0);
+}
+
+void MovementArrays::integrate(float deltaTime)
+{
+    integrate(deltaTime, 0, posX.size());
+}
+
+void MovementArrays::integrate(float deltaTime, int begin, int end)
+{
+    begin = std::max(begin, 0);
+    end = std::min(end, (int)posX.size());
+    if (begin < end)
+        integrateArrays(end - begin, deltaTime, width, height, &posX[begin], &posY[begin], &dirX[begin], &dirY[begin],
+            &speeds[begin], &moving[begin], &edgeHits[begin]);
+}
+
+bool MovementArrays::isMoving(int index) const
+{
+    return (index >= 0 && index < (int)moving.size() && moving[index] != 0);
+}
+
+sf::Vector2f MovementArrays::getPos(int index) const
+{
+    return sf::Vector2f(posX[index], posY[index]);
+}
+
+int MovementArrays::getEdgeHits(int index) const
+{
+    return edgeHits[index];
+}
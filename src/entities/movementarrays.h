@@ -0,0 +1,50 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef MOVEMENTARRAYS_H
+#define MOVEMENTARRAYS_H
+
+#include <vector>
+#include <SFML/System.hpp>
+
+/*
+This class stores the movement state of all of the entities in separate contiguous arrays, accessed by index.
+    The index is the index part of the entity's ID (see entityid.h), so the arrays stay as small as the entity list.
+    This lets all of the entities be moved in a single tight loop, without any virtual calls, pointer chasing, or trig.
+    The loop has no branches, so the compiler can vectorize it.
+The entities attached to this write their state into it whenever it changes,
+    and get their new positions back after integrating.
+Entities that aren't moving (or IDs that aren't used) still get integrated, but they just don't go anywhere.
+This is only used on the server, the client moves its entities by themselves.
+*/
+class MovementArrays
+{
+    public:
+        MovementArrays();
+        void setBounds(float, float); // Sets the width and height of the map in pixels
+        void clear();
+        unsigned size() const;
+
+        // Sets all of the movement state of an entity (the direction is a unit vector)
+        void set(int, const sf::Vector2f&, const sf::Vector2f&, float, bool);
+        void remove(int); // Stops the entity from moving
+        void resize(unsigned); // Drops the entities at the end, or adds ones that aren't moving
+
+        // Moves all of the moving entities and clamps them to the map bounds
+        void integrate(float);
+        void integrate(float, int, int); // Only the indexes in [begin, end), separate ranges can be done on different threads
+
+        bool isMoving(int) const;
+        sf::Vector2f getPos(int) const;
+        int getEdgeHits(int) const; // How many map edges the entity went past during the last integrate
+
+    private:
+        float width, height;
+        std::vector<float> posX, posY;
+        std::vector<float> dirX, dirY;
+        std::vector<float> speeds; // in pixels per second
+        std::vector<float> moving; // 1 if moving, 0 if not, so it can be multiplied instead of branched on
+        std::vector<sf::Uint8> edgeHits;
+};
+
+#endif
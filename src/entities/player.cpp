@@ -2,13 +2,13 @@
 // See the file LICENSE.txt for copying conditions.
 
 #include "player.h"
+#include "packetcodec.h"
 
 PlayerEntity::PlayerEntity()
 {
     type = Entity::Player;
     speed = 400;
     visualAngle = 0;
-    setTexture(type);
 }
 
 void PlayerEntity::update(float time)
@@ -21,21 +21,18 @@ bool PlayerEntity::collides(Entity* ent)
     return false;
 }
 
-void PlayerEntity::draw(sf::RenderTarget& window, sf::RenderStates states) const
+void PlayerEntity::getData(sf::Packet& packet, sf::Uint8 fields)
 {
-    window.draw(sprite);
+    MobileEntity::getData(packet, fields);
+    if (fields & VisualAngle)
+        PacketCodec::writeAngle(packet, visualAngle);
 }
 
-void PlayerEntity::getData(sf::Packet& packet)
+void PlayerEntity::setData(sf::Packet& packet, sf::Uint8 fields)
 {
-    packet << id << type << pos.x << pos.y << angle << speed << moving << currentHealth << baseHealth << visualAngle;
-}
-
-void PlayerEntity::setData(sf::Packet& packet)
-{
-    packet >> pos.x >> pos.y >> angle >> speed >> moving >> currentHealth >> baseHealth >> visualAngle;
-    sprite.setPosition(pos);
-    updateSpriteRotation();
+    MobileEntity::setData(packet, fields);
+    if (fields & VisualAngle)
+        PacketCodec::readAngle(packet, visualAngle);
 }
 
 float PlayerEntity::getVisualAngle() const
@@ -46,11 +43,5 @@ float PlayerEntity::getVisualAngle() const
 void PlayerEntity::setVisualAngle(float ang)
 {
     visualAngle = ang;
-    updateSpriteRotation();
-    changed = true;
-}
-
-void PlayerEntity::updateSpriteRotation()
-{
-    sprite.setRotation(visualAngle + 90);
+    markChanged(VisualAngle);
 }
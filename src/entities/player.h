@@ -12,12 +12,10 @@ class PlayerEntity: public MobileEntity
         PlayerEntity();
         void update(float);
         bool collides(Entity*);
-        void draw(sf::RenderTarget&, sf::RenderStates) const;
-        void getData(sf::Packet&);
-        void setData(sf::Packet&);
+        void getData(sf::Packet&, sf::Uint8);
+        void setData(sf::Packet&, sf::Uint8);
         float getVisualAngle() const;
         void setVisualAngle(float);
-        void updateSpriteRotation();
 
     private:
         float visualAngle;
@@ -7,7 +7,6 @@ Zombie::Zombie()
 {
     type = Entity::Zombie;
     speed = 50;
-    setTexture(type);
 }
 
 /*
@@ -24,19 +23,3 @@ bool Zombie::collides(Entity* ent)
 {
     return false;
 }
-
-void Zombie::draw(sf::RenderTarget& window, sf::RenderStates states) const
-{
-    window.draw(sprite);
-}
-
-void Zombie::getData(sf::Packet& packet)
-{
-    packet << id << type << pos.x << pos.y << angle << speed << moving << currentHealth << baseHealth;
-}
-
-void Zombie::setData(sf::Packet& packet)
-{
-    packet >> pos.x >> pos.y >> angle >> speed >> moving >> currentHealth >> baseHealth;
-    sprite.setPosition(pos);
-}
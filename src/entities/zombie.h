@@ -17,9 +17,6 @@ class Zombie: public MobileEntity
         Zombie();
         void update(float);
         bool collides(Entity*);
-        void draw(sf::RenderTarget&, sf::RenderStates) const;
-        void getData(sf::Packet&);
-        void setData(sf::Packet&);
 };
 
 #endif
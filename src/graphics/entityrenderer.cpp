@@ -0,0 +1,41 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "entityrenderer.h"
+#include "paths.h"
+
+EntityRenderer::EntityRenderer()
+{
+}
+
+void EntityRenderer::loadTextures()
+{
+    if (textures.isLoaded())
+        return;
+    textures.setTileSize(64, 64);
+    textures.loadImage(Paths::entitiesImage, true);
+
+    // The textures are in the same order as the entity types
+    sprites.clear();
+    sprites.resize(textures.size());
+    for (unsigned int type = 0; type < sprites.size(); ++type)
+    {
+        EntitySprite& entSprite = sprites[type];
+        entSprite.sprite.setTexture(textures[type]);
+        entSprite.rotates = (type == Entity::Player || type == Entity::Zombie);
+        if (entSprite.rotates)
+            entSprite.sprite.setOrigin(32, 32);
+    }
+}
+
+void EntityRenderer::draw(sf::RenderTarget& window, const Entity& ent, sf::RenderStates states) const
+{
+    EType type = ent.getType();
+    if (type < 0 || type >= (EType)sprites.size())
+        return;
+    EntitySprite& entSprite = sprites[type];
+    entSprite.sprite.setPosition(ent.getPos());
+    if (entSprite.rotates)
+        entSprite.sprite.setRotation(ent.getVisualAngle() + 90);
+    window.draw(entSprite.sprite, states);
+}
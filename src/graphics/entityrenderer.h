@@ -0,0 +1,35 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef ENTITYRENDERER_H
+#define ENTITYRENDERER_H
+
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "tileset.h"
+#include "entity.h"
+
+/*
+This class draws entities, so that the entities themselves don't need any graphics.
+There is one sprite for each type of entity, which gets moved to each entity as it is drawn.
+    Mobile entities are rotated to the angle they are facing (see Entity::getVisualAngle).
+*/
+class EntityRenderer
+{
+    public:
+        EntityRenderer();
+        void loadTextures();
+        void draw(sf::RenderTarget&, const Entity&, sf::RenderStates = sf::RenderStates::Default) const;
+
+    private:
+        struct EntitySprite
+        {
+            sf::Sprite sprite;
+            bool rotates;
+        };
+
+        TileSet textures;
+        mutable std::vector<EntitySprite> sprites; // Accessed by entity type
+};
+
+#endif
@@ -0,0 +1,64 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "tilemaprenderer.h"
+#include "paths.h"
+
+TileMapRenderer::TileMapRenderer(const TileMap& tileMap):
+    tileMap(tileMap)
+{
+}
+
+void TileMapRenderer::loadTextures()
+{
+    if (!textures.isLoaded())
+    {
+        textures.setTileSize(Tile::tileWidth, Tile::tileHeight);
+        textures.loadImage(Paths::tilesImage);
+    }
+}
+
+void TileMapRenderer::draw(sf::RenderTarget& window, sf::RenderStates states) const
+{
+    if (!tileMap.isReady())
+        return;
+
+    // No need to pass the view in separately, it is already stored inside the window
+    sf::View viewWindow = window.getView();
+
+    sf::Vector2f viewSize(viewWindow.getSize());
+    sf::Vector2f viewCenter(viewWindow.getCenter());
+    sf::FloatRect viewRect(viewCenter.x - viewSize.x / 2, viewCenter.y - viewSize.y / 2, viewSize.x, viewSize.y);
+
+    // Convert coordinates of view to logical tile coordinates
+    int startX = viewRect.left / Tile::tileWidth;
+    int startY = viewRect.top / Tile::tileHeight;
+
+    int endX = (viewRect.left + viewRect.width) / Tile::tileWidth + 1;
+    int endY = (viewRect.top + viewRect.height) / Tile::tileHeight + 1;
+
+    // Check if these values are within bounds of the map
+    if (startX < 0)
+        startX = 0;
+    if (startY < 0)
+        startY = 0;
+    if (endX >= (int)tileMap.getWidth())
+        endX = tileMap.getWidth() - 1;
+    if (endY >= (int)tileMap.getHeight())
+        endY = tileMap.getHeight() - 1;
+
+    // Draw all of the tiles within view, the textures are looked up from the tile IDs
+    for (int y = startY; y < endY; y++)
+    {
+        for (int x = startX; x < endX; x++)
+        {
+            TileID id = tileMap.getTile(x, y).getID();
+            if (id < textures.size())
+            {
+                sprite.setTexture(textures[id]);
+                sprite.setPosition(x * Tile::tileWidth, y * Tile::tileHeight);
+                window.draw(sprite, states);
+            }
+        }
+    }
+}
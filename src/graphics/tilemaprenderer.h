@@ -0,0 +1,29 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef TILEMAPRENDERER_H
+#define TILEMAPRENDERER_H
+
+#include <SFML/Graphics.hpp>
+#include "tileset.h"
+#include "tilemap.h"
+
+/*
+This class draws a TileMap, so that the tile map itself doesn't need any graphics.
+Only the tiles inside of the current view are drawn, using a single sprite.
+The tile map must outlive this renderer.
+*/
+class TileMapRenderer: public sf::Drawable
+{
+    public:
+        TileMapRenderer(const TileMap&);
+        void loadTextures();
+        void draw(sf::RenderTarget&, sf::RenderStates) const;
+
+    private:
+        const TileMap& tileMap;
+        TileSet textures;
+        mutable sf::Sprite sprite;
+};
+
+#endif
@@ -115,6 +115,15 @@ sf::Texture& TileSet::operator[](unsigned int i)
     return textures[i];
 }
 
+const sf::Texture& TileSet::operator[](unsigned int i) const
+{
+    if (textures.empty())
+        exit(120);
+    if (i >= textures.size())
+        i = textures.size() - 1;
+    return textures[i];
+}
+
 unsigned int TileSet::size() const
 {
     return textures.size();
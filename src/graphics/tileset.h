@@ -27,6 +27,7 @@ class TileSet
         void clear(); // Clears all of the textures
 
         sf::Texture& operator[](unsigned int); // Returns a reference to a texture in the vector
+        const sf::Texture& operator[](unsigned int) const;
         unsigned int size() const; // Returns number of textures
         bool empty() const; // Returns true if there are no textures
         bool isLoaded() const; // Returns true if there was already a successful call to loadImage
@@ -0,0 +1,224 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "bot.h"
+#include <cmath>
+#include "packet.h"
+#include "packetcodec.h"
+
+// Microsecond buckets, so the histograms can hold up to a second
+const unsigned histogramBucketWidth = 1000;
+
+BotStats::BotStats():
+    latency(histogramBucketWidth),
+    updateIntervals(histogramBucketWidth)
+{
+    clear();
+}
+
+void BotStats::clear()
+{
+    latency.clear();
+    updateIntervals.clear();
+    updateBytes = 0;
+    updates = 0;
+    packetsSent = 0;
+    loginFailures = 0;
+    maxQueuePosition = 0;
+}
+
+Bot::Bot(const std::string& username, const BotBehavior& behavior, BotStats& stats, unsigned seed):
+    username(username),
+    behavior(behavior),
+    stats(stats),
+    random(seed),
+    state(Disconnected),
+    playerId(0),
+    hasPlayerId(false),
+    angleTimer(0),
+    visualAngle(0),
+    waitingForAngle(false),
+    hasUpdated(false)
+{
+    using namespace std::placeholders;
+    client.registerCallback(Packet::LogInStatus, std::bind(&Bot::handleLogInStatus, this, _1));
+    client.registerCallback(Packet::LogInQueue, std::bind(&Bot::handleLogInQueue, this, _1));
+    client.registerCallback(Packet::OnSuccessfulLogIn, std::bind(&Bot::handleOnLogIn, this, _1));
+    client.registerCallback(Packet::EntityUpdate, std::bind(&Bot::handleEntityUpdate, this, _1));
+
+    // The bots don't need anything from these, but they still need to be received
+    auto ignorePacket = [](sf::Packet&){};
+    client.registerCallback(Packet::CreateAccountStatus, ignorePacket);
+    client.registerCallback(Packet::ChatMessage, ignorePacket);
+    client.registerCallback(Packet::MapData, ignorePacket);
+    client.registerCallback(Packet::InventoryUpdate, ignorePacket);
+}
+
+bool Bot::start(const net::Address& address)
+{
+    if (!client.connect(address, sf::seconds(5)))
+    {
+        state = Failed;
+        return false;
+    }
+    state = LoggingIn;
+
+    // The server handles these in order, so the account will exist by the time the log in is handled
+    // (If the account already exists from an earlier run, creating it fails and logging in still works)
+    const std::string password = "loadtest";
+    sf::Packet createAccountPacket;
+    createAccountPacket << Packet::CreateAccount << Packet::ProtocolVersion << username << password;
+    send(createAccountPacket);
+    sf::Packet loginPacket;
+    loginPacket << Packet::LogIn << Packet::ProtocolVersion << username << password;
+    send(loginPacket);
+    return true;
+}
+
+void Bot::update(float dt)
+{
+    if (state != LoggingIn && state != Playing)
+        return;
+    if (!client.isConnected())
+    {
+        state = Disconnected;
+        return;
+    }
+    client.receive();
+    entList.update(dt);
+    if (state == Playing)
+        sendInputs(dt);
+}
+
+Bot::State Bot::getState() const
+{
+    return state;
+}
+
+void Bot::handleLogInStatus(sf::Packet& packet)
+{
+    int status = Packet::LogInCode::UnknownFailure;
+    packet >> status;
+    if (status == Packet::LogInCode::Successful)
+        state = Playing;
+    else
+    {
+        ++stats.loginFailures;
+        state = Failed;
+        client.disconnect();
+    }
+}
+
+void Bot::handleLogInQueue(sf::Packet& packet)
+{
+    sf::Uint32 position = 0;
+    if (packet >> position && position > stats.maxQueuePosition)
+        stats.maxQueuePosition = position;
+}
+
+void Bot::handleOnLogIn(sf::Packet& packet)
+{
+    hasPlayerId = static_cast<bool>(packet >> playerId);
+}
+
+void Bot::handleEntityUpdate(sf::Packet& packet)
+{
+    stats.updateBytes += packet.getDataSize();
+    ++stats.updates;
+    if (hasUpdated)
+        stats.updateIntervals.record(updateClock.restart().asMicroseconds());
+    else
+    {
+        updateClock.restart();
+        hasUpdated = true;
+    }
+
+    // Same as the real client: apply everything, then acknowledge it if it all worked
+    sf::Uint32 sequence = 0;
+    if (!(packet >> sequence))
+        return;
+    sf::Uint32 entId;
+    bool applied = true;
+    while (PacketCodec::readVarInt(packet, entId))
+        applied = (entList.updateEntity(entId, packet) && applied);
+    if (applied)
+    {
+        sf::Packet ackPacket;
+        ackPacket << Packet::SnapshotAck << sequence;
+        send(ackPacket);
+    }
+    checkLatency();
+}
+
+void Bot::sendInputs(float dt)
+{
+    if (randomChance(behavior.moveInterval, dt))
+    {
+        sf::Packet inputPacket;
+        inputPacket << Packet::Input;
+        // Stop once in a while, but mostly keep walking around
+        if (std::uniform_int_distribution<int>(0, 3)(random) == 0)
+            inputPacket << Packet::InputType::StopMoving;
+        else
+            inputPacket << Packet::InputType::StartMoving << std::uniform_int_distribution<int>(0, 7)(random) * 45.0f;
+        send(inputPacket);
+    }
+
+    // Only one angle is measured at a time, so a lost update doesn't make every later measurement wrong
+    angleTimer += dt;
+    if (angleTimer >= behavior.angleInterval && (!waitingForAngle || latencyClock.getElapsedTime().asSeconds() >= 1))
+    {
+        angleTimer = 0;
+        // Always change by a large enough amount so the angle can be told apart from the last one
+        visualAngle = std::fmod(visualAngle + std::uniform_real_distribution<float>(30, 330)(random), 360.0f);
+        sf::Packet anglePacket;
+        anglePacket << Packet::Input << Packet::InputType::ChangeVisualAngle << visualAngle;
+        send(anglePacket);
+        waitingForAngle = true;
+        latencyClock.restart();
+    }
+
+    if (randomChance(behavior.chatInterval, dt))
+    {
+        sf::Packet chatPacket;
+        chatPacket << Packet::ChatMessage << Packet::Chat::Public << ("Hello from " + username);
+        send(chatPacket);
+    }
+
+    if (randomChance(behavior.pickupInterval, dt))
+    {
+        sf::Packet pickupPacket;
+        pickupPacket << Packet::Input << Packet::InputType::PickupItem;
+        send(pickupPacket);
+    }
+}
+
+void Bot::send(sf::Packet& packet)
+{
+    client.send(packet);
+    ++stats.packetsSent;
+}
+
+bool Bot::randomChance(float interval, float dt)
+{
+    if (interval <= 0)
+        return false;
+    return (std::uniform_real_distribution<float>(0, interval)(random) < dt);
+}
+
+void Bot::checkLatency()
+{
+    if (!waitingForAngle || !hasPlayerId)
+        return;
+    Entity* player = entList.find(playerId);
+    if (player != nullptr)
+    {
+        // The angle is rounded when it is sent, so it only needs to be close
+        float difference = std::fabs(player->getVisualAngle() - visualAngle);
+        if (difference < 2 || difference > 358)
+        {
+            stats.latency.record(latencyClock.getElapsedTime().asMicroseconds());
+            waitingForAngle = false;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef BOT_H
+#define BOT_H
+
+#include <string>
+#include <random>
+#include <SFML/System.hpp>
+#include "client.h"
+#include "entitylist.h"
+#include "latencyhistogram.h"
+
+// The measurements from all of the bots, added together
+struct BotStats
+{
+    BotStats();
+    void clear(); // Clears everything except for the total bot counts
+
+    LatencyHistogram latency; // From sending a visual angle to seeing it in an entity update, in microseconds
+    LatencyHistogram updateIntervals; // Time between entity updates for a single bot, in microseconds
+    unsigned long long updateBytes; // Size of the entity updates received
+    unsigned updates;
+    unsigned packetsSent;
+    unsigned loginFailures;
+    unsigned maxQueuePosition; // The furthest back in the server's login queue that a bot was
+};
+
+// The timing of the inputs that the bots send, all in seconds
+struct BotBehavior
+{
+    float moveInterval; // Average time between starting to move in a new direction (or stopping)
+    float angleInterval; // Time between changing the visual angle
+    float chatInterval; // Average time between chat messages
+    float pickupInterval; // Average time between trying to pick up items
+};
+
+/*
+This class is a fake player that connects to a server and plays the game by itself, for load testing.
+It sends the same packets as the real client, and applies the entity updates it gets to its own entity list.
+    It acknowledges the updates like the real client, so the server sends it deltas instead of full updates.
+The latency is measured by changing the visual angle of its player, and waiting until an update has the new angle.
+*/
+class Bot
+{
+    public:
+        enum State
+        {
+            Disconnected,
+            LoggingIn,
+            Playing,
+            Failed
+        };
+
+        Bot(const std::string&, const BotBehavior&, BotStats&, unsigned); // Username, behavior, stats, random seed
+        bool start(const net::Address&); // Connects, creates the account (if it doesn't exist), and logs in
+        void update(float); // Receives packets and sends inputs
+        State getState() const;
+
+    private:
+        void handleLogInStatus(sf::Packet&);
+        void handleLogInQueue(sf::Packet&);
+        void handleOnLogIn(sf::Packet&);
+        void handleEntityUpdate(sf::Packet&);
+        void sendInputs(float);
+        void send(sf::Packet&);
+        bool randomChance(float, float); // Returns true on average once per interval (in seconds), given the elapsed time
+        void checkLatency();
+
+        net::Client client;
+        std::string username;
+        const BotBehavior& behavior;
+        BotStats& stats;
+        std::mt19937 random;
+        State state;
+        EntityList entList;
+        EID playerId;
+        bool hasPlayerId;
+
+        float angleTimer;
+        float visualAngle;
+        bool waitingForAngle; // True until the last visual angle sent shows up in an update
+        sf::Clock latencyClock; // Restarted when a visual angle is sent
+        sf::Clock updateClock; // Restarted when an entity update is received
+        bool hasUpdated;
+};
+
+#endif
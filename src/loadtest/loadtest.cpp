@@ -0,0 +1,121 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "loadtest.h"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include "paths.h"
+
+const cfg::File::ConfigMap LoadTest::defaultOptions = {
+{"", {
+    {"address", cfg::makeOption("127.0.0.1")},
+    {"port", cfg::makeOption(1337, 1, 65536)},
+    {"bots", cfg::makeOption(500, 1)},
+    {"rampRate", cfg::makeOption(10.0, 0.1)},
+    {"reportInterval", cfg::makeOption(5.0, 0.1)},
+    {"duration", cfg::makeOption(0.0, 0.0)},
+    {"updateRate", cfg::makeOption(60, 1, 1000)},
+    {"moveInterval", cfg::makeOption(2.0, 0.0)},
+    {"angleInterval", cfg::makeOption(0.1, 0.0)},
+    {"chatInterval", cfg::makeOption(30.0, 0.0)},
+    {"pickupInterval", cfg::makeOption(10.0, 0.0)},
+    {"usernamePrefix", cfg::makeOption("bot")}
+}}};
+
+LoadTest::LoadTest():
+    config(Paths::loadTestConfigFile, defaultOptions, cfg::File::Warnings | cfg::File::Errors),
+    address(config("address").toString())
+{
+    if (address.port == 0)
+        address.port = config("port").toInt();
+    behavior.moveInterval = config("moveInterval").toFloat();
+    behavior.angleInterval = config("angleInterval").toFloat();
+    behavior.chatInterval = config("chatInterval").toFloat();
+    behavior.pickupInterval = config("pickupInterval").toFloat();
+}
+
+void LoadTest::run()
+{
+    const unsigned totalBots = config("bots").toInt();
+    const float rampRate = config("rampRate").toFloat();
+    const float reportInterval = config("reportInterval").toFloat();
+    const float duration = config("duration").toFloat();
+    const sf::Time updateTime = sf::seconds(1.0f / config("updateRate").toInt());
+
+    std::cout << "Starting " << totalBots << " bots against " << address.toString() << " at " << rampRate << " bots/s.\n";
+    sf::Clock totalTime;
+    sf::Clock reportTimer;
+    sf::Clock frameTimer;
+    while (duration <= 0 || totalTime.getElapsedTime().asSeconds() < duration)
+    {
+        // Keep adding bots until there are as many as the ramp rate says there should be by now
+        unsigned targetBots = std::min<unsigned>(totalBots, 1 + totalTime.getElapsedTime().asSeconds() * rampRate);
+        if (bots.size() < targetBots)
+            addBots(targetBots - bots.size());
+
+        float dt = frameTimer.restart().asSeconds();
+        for (auto& bot: bots)
+            bot->update(dt);
+
+        float reportTime = reportTimer.getElapsedTime().asSeconds();
+        if (reportTime >= reportInterval)
+        {
+            printReport(reportTime);
+            reportTimer.restart();
+        }
+
+        sf::Time remaining = updateTime - frameTimer.getElapsedTime();
+        if (remaining > sf::Time::Zero)
+            sf::sleep(remaining);
+    }
+    printReport(reportTimer.getElapsedTime().asSeconds());
+}
+
+void LoadTest::addBots(unsigned count)
+{
+    const std::string prefix = config("usernamePrefix").toString();
+    for (unsigned i = 0; i < count; ++i)
+    {
+        unsigned number = bots.size();
+        bots.emplace_back(new Bot(prefix + std::to_string(number), behavior, stats, number));
+        if (!bots.back()->start(address))
+            std::cout << "Bot " << number << " could not connect.\n";
+    }
+}
+
+void LoadTest::printReport(float elapsed)
+{
+    unsigned playing = 0;
+    unsigned failed = 0;
+    for (auto& bot: bots)
+    {
+        Bot::State state = bot->getState();
+        if (state == Bot::Playing)
+            ++playing;
+        else if (state == Bot::Failed || state == Bot::Disconnected)
+            ++failed;
+    }
+    float kBytesPerSecond = stats.updateBytes / 1024.0f / elapsed;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Bots: " << playing << " playing, " << failed << " failed/disconnected, " << bots.size() << " started\n";
+    std::cout << "    Updates: " << stats.updates / elapsed << "/s, " << kBytesPerSecond << " kB/s";
+    if (playing > 0)
+        std::cout << " (" << kBytesPerSecond / playing << " kB/s per bot)";
+    std::cout << ", sent " << stats.packetsSent / elapsed << " packets/s\n";
+    std::cout << "    Latency (ms): p50 " << stats.latency.getPercentile(50) / 1000.0f;
+    std::cout << ", p99 " << stats.latency.getPercentile(99) / 1000.0f;
+    std::cout << ", max " << stats.latency.getMax() / 1000.0f;
+    std::cout << " (" << stats.latency.getCount() << " samples)\n";
+    std::cout << "    Update interval (ms): p50 " << stats.updateIntervals.getPercentile(50) / 1000.0f;
+    std::cout << ", p99 " << stats.updateIntervals.getPercentile(99) / 1000.0f;
+    std::cout << ", max " << stats.updateIntervals.getMax() / 1000.0f << "\n";
+    if (stats.loginFailures > 0)
+        std::cout << "    Log in failures: " << stats.loginFailures << "\n";
+    if (stats.maxQueuePosition > 0)
+        std::cout << "    Furthest back in the login queue: " << stats.maxQueuePosition << "\n";
+    std::cout.unsetf(std::ios::fixed);
+    stats.clear();
+}
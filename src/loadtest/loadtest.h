@@ -0,0 +1,40 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef LOADTEST_H
+#define LOADTEST_H
+
+#include <vector>
+#include <memory>
+#include <SFML/System.hpp>
+#include "configfile.h"
+#include "bot.h"
+
+/*
+This class runs a load test against a server: it starts bots over time, and prints a report every few seconds.
+The bots are all updated from one thread, since each one only has a little bit of work to do.
+The reports show how the server keeps up as more bots are added:
+    The update latency is the time from a bot changing its angle to seeing that change in an entity update.
+    The update interval is the time between entity updates, which grows when the server can't finish its ticks on time.
+        (The server's own tick times are printed by its profiler, see the profileInterval option in server.cfg)
+*/
+class LoadTest
+{
+    public:
+        LoadTest();
+        void run();
+
+    private:
+        void addBots(unsigned);
+        void printReport(float);
+
+        static const cfg::File::ConfigMap defaultOptions;
+        cfg::File config;
+
+        net::Address address;
+        BotBehavior behavior;
+        BotStats stats;
+        std::vector<std::unique_ptr<Bot>> bots;
+};
+
+#endif
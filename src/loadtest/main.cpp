@@ -0,0 +1,10 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "loadtest.h"
+
+int main()
+{
+    LoadTest loadTest;
+    loadTest.run();
+}
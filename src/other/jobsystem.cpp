@@ -0,0 +1,122 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "jobsystem.h"
+#include <algorithm>
+
+JobSystem::JobSystem(unsigned threadCount):
+    queuedJobs(0),
+    running(true)
+{
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned i = 0; i < threadCount; ++i)
+        queues.emplace_back(new JobQueue);
+    for (unsigned i = 1; i < threadCount; ++i)
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wakeUp.notify_all();
+    for (auto& worker: workers)
+        worker.join();
+}
+
+void JobSystem::parallelFor(int count, int grainSize, const RangeFunction& func)
+{
+    grainSize = std::max(grainSize, 1);
+    if (count <= 0)
+        return;
+    if (workers.empty() || count <= grainSize)
+    {
+        func(0, count);
+        return;
+    }
+
+    int jobCount = (count + grainSize - 1) / grainSize;
+    std::atomic<int> remaining(jobCount);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedJobs += jobCount;
+    }
+
+    // Deal the ranges out to all of the queues, the threads will steal from each other if they get uneven
+    for (int i = 0; i < jobCount; ++i)
+    {
+        int begin = i * grainSize;
+        int end = std::min(begin + grainSize, count);
+        JobQueue& queue = *queues[i % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.emplace_back([&func, &remaining, begin, end]
+        {
+            func(begin, end);
+            remaining.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    wakeUp.notify_all();
+
+    // Help out until everything is done (the last jobs might still be running on other threads)
+    while (remaining.load(std::memory_order_acquire) > 0)
+    {
+        if (!runJob(0))
+            std::this_thread::yield();
+    }
+}
+
+unsigned JobSystem::getThreadCount() const
+{
+    return queues.size();
+}
+
+void JobSystem::workerLoop(unsigned index)
+{
+    while (true)
+    {
+        if (!runJob(index))
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wakeUp.wait(lock, [this]{ return (!running || queuedJobs > 0); });
+            if (!running)
+                return;
+        }
+    }
+}
+
+bool JobSystem::runJob(unsigned index)
+{
+    Job job;
+    // Newest job from its own queue first, since that is most likely to still be in the cache
+    {
+        JobQueue& queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty())
+        {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+    }
+    // Otherwise steal the oldest job from another thread
+    for (unsigned i = 1; !job && i < queues.size(); ++i)
+    {
+        JobQueue& queue = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty())
+        {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+    }
+    if (!job)
+        return false;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        --queuedJobs;
+    }
+    job();
+    return true;
+}
@@ -0,0 +1,71 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/*
+This class runs jobs on a pool of worker threads, using work stealing.
+Every thread has its own queue of jobs. A thread takes jobs from the back of its own queue,
+    and when that is empty, it steals jobs from the front of the other threads' queues.
+    This keeps all of the threads busy even when some jobs take much longer than others,
+        without every thread fighting over a single shared queue.
+The thread that calls parallelFor also runs jobs until they are all finished, so it counts as one of the threads.
+    With 1 thread, everything just runs on the calling thread.
+Only one thread can call parallelFor at a time, and the jobs can't call it either.
+
+Example usage:
+JobSystem jobs(4);
+jobs.parallelFor(values.size(), 1000, [&](int begin, int end)
+{
+    for (int i = begin; i < end; ++i)
+        values[i] *= 2;
+});
+*/
+class JobSystem
+{
+    public:
+        using RangeFunction = std::function<void(int, int)>;
+
+        JobSystem(unsigned threadCount = 0); // Total threads including the calling thread, 0 for one per core
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        // Splits [0, count) into ranges of up to grainSize, and calls the function with each range as a job
+        // Returns once all of the ranges are done
+        void parallelFor(int count, int grainSize, const RangeFunction& func);
+
+        unsigned getThreadCount() const;
+
+    private:
+        using Job = std::function<void()>;
+
+        struct JobQueue
+        {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        void workerLoop(unsigned);
+        bool runJob(unsigned); // Runs one job from a thread's own queue, or steals one, returns false if there were none
+
+        std::vector<std::unique_ptr<JobQueue>> queues; // One for each thread, the calling thread uses the first one
+        std::vector<std::thread> workers;
+        std::mutex sleepMutex;
+        std::condition_variable wakeUp;
+        int queuedJobs; // Protected by sleepMutex, only used for deciding when to sleep
+        bool running;
+};
+
+#endif
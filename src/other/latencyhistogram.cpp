@@ -0,0 +1,58 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "latencyhistogram.h"
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram(unsigned bucketWidth):
+    bucketWidth(bucketWidth > 0 ? bucketWidth : 1)
+{
+    clear();
+}
+
+void LatencyHistogram::record(long long value)
+{
+    value = std::max(value, 0LL);
+    unsigned bucket = std::min<long long>(value / bucketWidth, bucketCount - 1);
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    // If another thread changes the max first, this gets the new max and tries again
+    long long currentMax = maxValue.load(std::memory_order_relaxed);
+    while (value > currentMax && !maxValue.compare_exchange_weak(currentMax, value, std::memory_order_relaxed));
+}
+
+void LatencyHistogram::clear()
+{
+    for (auto& bucket: buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+unsigned LatencyHistogram::getCount() const
+{
+    return count.load(std::memory_order_relaxed);
+}
+
+long long LatencyHistogram::getPercentile(float percent) const
+{
+    unsigned total = getCount();
+    if (total == 0)
+        return 0;
+    // The number of values that need to be at or below the result
+    unsigned target = std::max<unsigned>(total * std::min(std::max(percent, 0.0f), 100.0f) / 100.0f, 1);
+    unsigned seen = 0;
+    for (unsigned i = 0; i + 1 < bucketCount; ++i)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target)
+            return std::min<long long>((i + 1) * bucketWidth, getMax());
+    }
+    // It's in the last bucket, which has everything too long for the other buckets
+    return getMax();
+}
+
+long long LatencyHistogram::getMax() const
+{
+    return maxValue.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,37 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+
+/*
+This class counts durations in fixed size buckets, so percentiles can be found without storing every value.
+Recording a value is just a couple of atomic operations, so any thread can record values without locking.
+    Reading the percentiles while other threads are recording is safe, but might miss the newest values.
+The buckets are all the same width (20 microseconds by default), and anything past the last bucket goes into the last one.
+    The maximum is tracked exactly though.
+*/
+class LatencyHistogram
+{
+    public:
+        static const unsigned bucketCount = 1000;
+        static const unsigned defaultBucketWidth = 20; // In microseconds (so the buckets go up to 20 ms)
+
+        LatencyHistogram(unsigned = defaultBucketWidth); // Bucket width in microseconds
+        void record(long long); // In microseconds
+        void clear();
+
+        unsigned getCount() const;
+        long long getPercentile(float) const; // 0 to 100, returns the upper edge of the bucket in microseconds
+        long long getMax() const;
+
+    private:
+        const unsigned bucketWidth;
+        std::atomic<unsigned> buckets[bucketCount];
+        std::atomic<unsigned> count;
+        std::atomic<long long> maxValue;
+};
+
+#endif
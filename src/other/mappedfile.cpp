@@ -0,0 +1,120 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "mappedfile.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::MappedFile():
+    data(nullptr),
+    size(0),
+    opened(false),
+    fileHandle(nullptr),
+    mappingHandle(nullptr)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    size = static_cast<std::size_t>(fileSize.QuadPart);
+    if (size > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr)
+        {
+            mappingHandle = mapping;
+            data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (data == nullptr)
+        {
+            close();
+            return false;
+        }
+    }
+#else
+    int file = ::open(filename.c_str(), O_RDONLY);
+    if (file == -1)
+        return false;
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0)
+    {
+        ::close(file);
+        return false;
+    }
+    size = static_cast<std::size_t>(fileStat.st_size);
+    if (size > 0)
+    {
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapped == MAP_FAILED)
+        {
+            ::close(file);
+            size = 0;
+            return false;
+        }
+        data = static_cast<const char*>(mapped);
+    }
+    ::close(file); // The mapping stays valid after the file is closed
+#endif
+    opened = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (data != nullptr)
+        UnmapViewOfFile(data);
+    if (mappingHandle != nullptr)
+        CloseHandle(mappingHandle);
+    if (fileHandle != nullptr)
+        CloseHandle(fileHandle);
+#else
+    if (data != nullptr)
+        munmap(const_cast<char*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+    opened = false;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+}
+
+bool MappedFile::isOpen() const
+{
+    return opened;
+}
+
+const char* MappedFile::getData() const
+{
+    return data;
+}
+
+std::size_t MappedFile::getSize() const
+{
+    return size;
+}
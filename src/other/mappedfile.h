@@ -0,0 +1,38 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+/*
+This class maps a whole file into memory as read-only, so it can be parsed without copying it into a buffer first.
+The operating system only loads the pages that are actually read.
+An empty file opens successfully, but has no data.
+*/
+class MappedFile
+{
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::string& filename);
+        void close();
+        bool isOpen() const;
+        const char* getData() const;
+        std::size_t getSize() const;
+
+    private:
+        const char* data;
+        std::size_t size;
+        bool opened;
+        void* fileHandle; // Only used on Windows
+        void* mappingHandle;
+};
+
+#endif
@@ -0,0 +1,187 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+#include <utility>
+#include <cstdint>
+
+/*
+This class is a lock-free queue for passing objects from any number of threads to a single thread.
+Pushing is one atomic exchange, so the threads that push never wait on each other or on the thread that pops.
+Popping is only done by one thread (the consumer), and never blocks either.
+    If a push is half finished when tryPop is called, tryPop acts like that object isn't there yet.
+        It will just be popped the next time instead.
+The objects pushed by one thread are always popped in the same order they were pushed.
+The type must be default constructible, and movable.
+
+The nodes come from blocks that are allocated a bunch at a time, and popped nodes are recycled instead of deleted.
+    So once the queue has grown to the most objects it ever holds at once, pushing and popping never allocate.
+    The free nodes are kept in a lock-free stack, which any thread can take nodes from.
+        The top of the stack is a node index with a counter, so a node that was taken and put back can't be mistaken.
+    The blocks are only freed when the queue is destroyed.
+        (If all of the block slots are used up, nodes are just allocated one at a time, which should never happen)
+
+Example usage:
+MpscQueue<int> queue;
+queue.push(5); // Any thread
+int value;
+while (queue.tryPop(value)) // Only the consumer thread
+    std::cout << value << "\n";
+*/
+template <class Type>
+class MpscQueue
+{
+    public:
+        static const unsigned blockSize = 256; // Nodes allocated at a time
+        static const unsigned maxBlocks = 4096;
+
+        MpscQueue():
+            freeTop(0),
+            blockCount(0)
+        {
+            for (auto& block: blocks)
+                block.store(nullptr, std::memory_order_relaxed);
+            tail = takeNode();
+            head.store(tail, std::memory_order_relaxed);
+        }
+
+        ~MpscQueue()
+        {
+            // Only the nodes that didn't come from a block need to be deleted one at a time
+            while (tail != nullptr)
+            {
+                Node* next = tail->next.load(std::memory_order_relaxed);
+                if (tail->index == heapIndex)
+                    delete tail;
+                tail = next;
+            }
+            for (auto& block: blocks)
+                delete[] block.load(std::memory_order_relaxed);
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        // Adds an object to the back of the queue, can be called from any thread
+        void push(Type value)
+        {
+            Node* node = takeNode();
+            node->value = std::move(value);
+            node->next.store(nullptr, std::memory_order_relaxed);
+            Node* prev = head.exchange(node, std::memory_order_acq_rel);
+            prev->next.store(node, std::memory_order_release);
+        }
+
+        // Moves the front object out of the queue, returns false if there is nothing to pop
+        // Only one thread can call this
+        bool tryPop(Type& value)
+        {
+            // The tail is always a node that was already popped (or the first empty one)
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if (next == nullptr)
+                return false;
+            value = std::move(next->value);
+            recycleNode(tail);
+            tail = next;
+            return true;
+        }
+
+        // Only the consumer thread can call this
+        bool empty() const
+        {
+            return (tail->next.load(std::memory_order_acquire) == nullptr);
+        }
+
+        // The number of nodes allocated in blocks, which is the most objects the queue has held at once (plus one)
+        unsigned getCapacity() const
+        {
+            unsigned count = blockCount.load(std::memory_order_relaxed);
+            return (count < maxBlocks ? count : maxBlocks) * blockSize;
+        }
+
+    private:
+        static const std::uint32_t heapIndex = 0xFFFFFFFF; // For nodes that weren't allocated in a block
+
+        struct Node
+        {
+            Node(): next(nullptr), nextFree(0), index(heapIndex) {}
+            std::atomic<Node*> next;
+            std::atomic<std::uint32_t> nextFree; // The index + 1 of the next node in the free stack (0 for none)
+            std::uint32_t index; // Where the node is in the blocks
+            Type value;
+        };
+
+        Node* getNode(std::uint32_t index) const
+        {
+            return &blocks[index / blockSize].load(std::memory_order_acquire)[index % blockSize];
+        }
+
+        // Takes a node from the free stack, or allocates a new block if there aren't any
+        Node* takeNode()
+        {
+            std::uint64_t top = freeTop.load(std::memory_order_acquire);
+            while (static_cast<std::uint32_t>(top) != 0)
+            {
+                // The node could be taken by another thread at the same time, but its memory is never freed,
+                // and the counter makes sure the exchange fails if the top changed at all
+                Node* node = getNode(static_cast<std::uint32_t>(top) - 1);
+                std::uint64_t newTop = ((top >> 32) + 1) << 32 | node->nextFree.load(std::memory_order_relaxed);
+                if (freeTop.compare_exchange_weak(top, newTop, std::memory_order_acq_rel, std::memory_order_acquire))
+                    return node;
+            }
+            return allocateBlock();
+        }
+
+        // Allocates a new block, keeps the first node, and puts the rest on the free stack
+        Node* allocateBlock()
+        {
+            unsigned blockIndex = blockCount.fetch_add(1, std::memory_order_relaxed);
+            if (blockIndex >= maxBlocks)
+                return new Node;
+            Node* block = new Node[blockSize];
+            for (unsigned i = 0; i < blockSize; ++i)
+            {
+                block[i].index = blockIndex * blockSize + i;
+                block[i].nextFree.store(block[i].index + 2, std::memory_order_relaxed); // Link to the next node
+            }
+            blocks[blockIndex].store(block, std::memory_order_release);
+            if (blockSize > 1)
+                pushFree(&block[1], &block[blockSize - 1]);
+            return &block[0];
+        }
+
+        void recycleNode(Node* node)
+        {
+            if (node->index == heapIndex)
+                delete node;
+            else
+            {
+                node->value = Type(); // Don't hold on to anything the object owned
+                pushFree(node, node);
+            }
+        }
+
+        // Pushes a chain of nodes (already linked together from first to last) onto the free stack
+        void pushFree(Node* first, Node* last)
+        {
+            std::uint64_t top = freeTop.load(std::memory_order_relaxed);
+            std::uint64_t newTop;
+            do
+            {
+                last->nextFree.store(static_cast<std::uint32_t>(top), std::memory_order_relaxed);
+                newTop = ((top >> 32) + 1) << 32 | (first->index + 1);
+            }
+            while (!freeTop.compare_exchange_weak(top, newTop, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        std::atomic<Node*> head; // The last node pushed, where the producers add to
+        Node* tail; // The last node popped, only used by the consumer
+        std::atomic<std::uint64_t> freeTop; // The counter in the upper 32 bits, and the index + 1 of the top node (0 if empty)
+        std::atomic<unsigned> blockCount;
+        std::atomic<Node*> blocks[maxBlocks];
+};
+
+#endif
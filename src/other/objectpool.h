@@ -0,0 +1,120 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <type_traits>
+
+/*
+This class allocates objects of a single type from large slabs of memory, instead of one at a time.
+Freed objects go onto a free list, and their space is reused by the next objects that get created.
+    This means that after the pool has grown to its peak size, creating/destroying objects doesn't touch the heap at all,
+        so lots of short lived objects don't fragment the heap over time.
+    The slabs are never freed until the pool is destroyed.
+Objects can also be released, which puts them on a pending list instead of destroying them right away.
+    All of the pending objects are destroyed at once by calling releasePending.
+    This is useful when other things might still be pointing to the objects until some point (like the end of a tick).
+The pool doesn't keep track of which objects are alive, so everything must be destroyed before the pool is.
+
+Example usage:
+ObjectPool<Zombie> zombies;
+Zombie* zombie = zombies.create();
+zombies.destroy(zombie); // The space will be used for the next zombie
+*/
+
+// Occupancy statistics of a pool
+struct PoolStats
+{
+    unsigned used; // Objects that are alive (including pending ones)
+    unsigned pending; // Objects waiting to be destroyed by releasePending
+    unsigned capacity; // Total objects that fit in all of the slabs
+    unsigned slabs;
+};
+
+template <class Type>
+class ObjectPool
+{
+    public:
+
+        static const unsigned defaultSlabSize = 256;
+
+        ObjectPool(unsigned objectsPerSlab = defaultSlabSize):
+            slabSize(objectsPerSlab > 0 ? objectsPerSlab : 1),
+            used(0)
+        {
+        }
+
+        // Constructs a new object in the pool, with any arguments for its constructor
+        template <typename... Args>
+        Type* create(Args&&... args)
+        {
+            if (freeSlots.empty())
+                addSlab();
+            Slot* slot = freeSlots.back();
+            freeSlots.pop_back();
+            ++used;
+            return new (slot) Type(std::forward<Args>(args)...);
+        }
+
+        // Destroys an object right away, and puts its space on the free list
+        void destroy(Type* obj)
+        {
+            if (obj != nullptr)
+            {
+                obj->~Type();
+                freeSlots.push_back(reinterpret_cast<Slot*>(obj));
+                --used;
+            }
+        }
+
+        // Destroys an object later, when releasePending is called
+        void release(Type* obj)
+        {
+            if (obj != nullptr)
+                pending.push_back(obj);
+        }
+
+        // Destroys all of the released objects
+        void releasePending()
+        {
+            for (Type* obj: pending)
+                destroy(obj);
+            pending.clear();
+        }
+
+        PoolStats getStats() const
+        {
+            PoolStats stats;
+            stats.used = used;
+            stats.pending = pending.size();
+            stats.capacity = slabs.size() * slabSize;
+            stats.slabs = slabs.size();
+            return stats;
+        }
+
+    private:
+
+        using Slot = typename std::aligned_storage<sizeof(Type), alignof(Type)>::type;
+
+        void addSlab()
+        {
+            slabs.emplace_back(new Slot[slabSize]);
+            Slot* slab = slabs.back().get();
+            // Push them in reverse, so the objects are created in memory order
+            freeSlots.reserve(freeSlots.size() + slabSize);
+            for (unsigned i = slabSize; i > 0; --i)
+                freeSlots.push_back(&slab[i - 1]);
+        }
+
+        unsigned slabSize; // Number of objects in each slab
+        unsigned used;
+        std::vector<std::unique_ptr<Slot[]>> slabs;
+        std::vector<Slot*> freeSlots;
+        std::vector<Type*> pending;
+};
+
+#endif
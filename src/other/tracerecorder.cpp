@@ -0,0 +1,168 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "tracerecorder.h"
+#include <iostream>
+#include <algorithm>
+#include <utility>
+
+static std::atomic<unsigned long long> nextRecorderId(1);
+
+TraceRecorder::Scope::Scope(TraceRecorder& recorder, const char* name):
+    recorder(recorder),
+    name(name)
+{
+    recorder.begin(name);
+}
+
+TraceRecorder::Scope::~Scope()
+{
+    recorder.end(name);
+}
+
+TraceRecorder::ThreadBuffer::ThreadBuffer(int threadId):
+    threadId(threadId),
+    events(new AtomicEvent[bufferSize]),
+    written(0),
+    flushed(0)
+{
+}
+
+TraceRecorder::TraceRecorder():
+    recorderId(nextRecorderId++),
+    enabled(false),
+    startTime(Clock::now()),
+    droppedEvents(0)
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    flush();
+}
+
+bool TraceRecorder::open(const std::string& filename)
+{
+    file.open(filename, std::ios::out | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening trace file: \"" << filename << "\"\n";
+        return false;
+    }
+    file << "[\n";
+    startTime = Clock::now();
+    enabled.store(true, std::memory_order_release);
+    return true;
+}
+
+bool TraceRecorder::isEnabled() const
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void TraceRecorder::begin(const char* name)
+{
+    if (isEnabled())
+        record(name, 'B');
+}
+
+void TraceRecorder::end(const char* name)
+{
+    if (isEnabled())
+        record(name, 'E');
+}
+
+void TraceRecorder::setThreadName(const std::string& name)
+{
+    if (!isEnabled())
+        return; // Otherwise every thread that names itself would get a buffer when nothing is recorded
+    ThreadBuffer& buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer.name = name;
+}
+
+void TraceRecorder::flush()
+{
+    if (!isEnabled())
+        return;
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    std::vector<Event> events;
+    for (auto& bufferPtr: buffers)
+    {
+        ThreadBuffer& buffer = *bufferPtr;
+        unsigned long long start = buffer.flushed;
+        unsigned long long end = buffer.written.load(std::memory_order_acquire);
+        if (end - start > bufferSize)
+        {
+            droppedEvents += end - start - bufferSize;
+            start = end - bufferSize;
+        }
+        events.clear();
+        for (unsigned long long i = start; i < end; ++i)
+        {
+            const AtomicEvent& event = buffer.events[i % bufferSize];
+            events.push_back(Event{event.name.load(std::memory_order_relaxed), event.timestamp.load(std::memory_order_relaxed),
+                                   event.type.load(std::memory_order_relaxed)});
+        }
+        // The thread keeps recording while this copies, so the oldest events could have been overwritten already
+        // The fence makes sure that if any copied field came from a newer event, the count below includes it
+        // The thread could also be in the middle of overwriting the event after the count, so that one is dropped too
+        std::atomic_thread_fence(std::memory_order_acquire);
+        unsigned long long after = buffer.written.load(std::memory_order_relaxed);
+        unsigned first = 0;
+        if (after - start >= bufferSize)
+        {
+            first = std::min<unsigned long long>(after - start - bufferSize + 1, events.size());
+            droppedEvents += first;
+        }
+        buffer.flushed = end;
+
+        for (unsigned i = first; i < events.size(); ++i)
+        {
+            const Event& event = events[i];
+            file << "{\"name\":\"" << event.name << "\",\"ph\":\"" << event.type << "\",\"ts\":" << event.timestamp
+                << ",\"pid\":1,\"tid\":" << buffer.threadId << "},\n";
+        }
+        if (!buffer.name.empty())
+        {
+            file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.threadId
+                << ",\"args\":{\"name\":\"" << buffer.name << "\"}},\n";
+            buffer.name.clear(); // Only needs to be written once
+        }
+    }
+    file.flush();
+    if (droppedEvents > 0)
+    {
+        std::cout << "WARNING: Dropped " << droppedEvents << " trace events, the trace buffers filled up before being flushed.\n";
+        droppedEvents = 0;
+    }
+}
+
+void TraceRecorder::record(const char* name, char type)
+{
+    ThreadBuffer& buffer = getThreadBuffer();
+    // Only this thread writes to the buffer, so the event is filled in before the count is published
+    unsigned long long index = buffer.written.load(std::memory_order_relaxed);
+    AtomicEvent& event = buffer.events[index % bufferSize];
+    // Pairs with the fence in flush, so a flush that copies any of these fields also sees the last count
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.timestamp.store(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - startTime).count(), std::memory_order_relaxed);
+    event.type.store(type, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::getThreadBuffer()
+{
+    // Each thread remembers its buffers, so the mutex is only locked the first time
+    static thread_local std::vector<std::pair<unsigned long long, ThreadBuffer*>> threadBuffers;
+    for (auto& threadBuffer: threadBuffers)
+    {
+        if (threadBuffer.first == recorderId)
+            return *threadBuffer.second;
+    }
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffers.emplace_back(new ThreadBuffer(buffers.size() + 1));
+    threadBuffers.emplace_back(recorderId, buffers.back().get());
+    return *buffers.back();
+}
@@ -0,0 +1,104 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+
+/*
+This class records when things begin and end on every thread, and writes them to a file in the Chrome trace event format.
+    The file can be loaded in chrome://tracing (or another trace viewer) to see everything on a timeline.
+Nothing is recorded until a file is opened, and recording costs almost nothing while it's off.
+Every thread writes to its own ring buffer, so recording an event never locks or waits on other threads.
+    If a thread records more events than fit in its buffer between flushes, the oldest ones are dropped.
+    A thread only gets a buffer once it records something (or names itself) while recording is on.
+    The events are atomics, since flush can copy one while its thread is overwriting it.
+        Any event that could have been overwritten during the copy gets dropped, like a seqlock.
+Call flush periodically from a single thread, to write the events that were recorded since the last flush.
+    The events are appended to the file, which is a JSON array that never gets closed (which the trace format allows),
+        so the file can be used even if the program is killed.
+The names of the events are not copied, so they must be string literals (or otherwise never be freed).
+
+Example usage:
+TraceRecorder tracer;
+tracer.open("trace.json");
+{
+    TraceRecorder::Scope scope(tracer, "Update");
+    update();
+}
+tracer.flush();
+*/
+class TraceRecorder
+{
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static const unsigned bufferSize = 65536; // Events per thread
+
+        // Records a begin event when this is made, and an end event when it is destroyed
+        class Scope
+        {
+            public:
+                Scope(TraceRecorder&, const char*);
+                ~Scope();
+
+            private:
+                TraceRecorder& recorder;
+                const char* name;
+        };
+
+        TraceRecorder();
+        ~TraceRecorder(); // Flushes the remaining events
+        bool open(const std::string&); // Starts recording to a file, returns false if the file couldn't be opened
+        bool isEnabled() const;
+        void begin(const char*);
+        void end(const char*);
+        void setThreadName(const std::string&); // Names the calling thread in the trace (only while recording)
+        void flush();
+
+    private:
+        struct Event
+        {
+            const char* name;
+            long long timestamp; // In microseconds since the file was opened
+            char type; // 'B' for begin, 'E' for end
+        };
+
+        // An event in a ring buffer, all of the fields are only accessed with relaxed ordering
+        struct AtomicEvent
+        {
+            std::atomic<const char*> name;
+            std::atomic<long long> timestamp;
+            std::atomic<char> type;
+        };
+
+        struct ThreadBuffer
+        {
+            ThreadBuffer(int);
+            int threadId;
+            std::string name; // Protected by buffersMutex
+            std::unique_ptr<AtomicEvent[]> events; // A ring buffer
+            std::atomic<unsigned long long> written; // Only changed by the thread that owns the buffer
+            unsigned long long flushed; // Only used by flush
+        };
+
+        void record(const char*, char);
+        ThreadBuffer& getThreadBuffer(); // Gets the calling thread's buffer, adding one the first time
+
+        const unsigned long long recorderId; // Used by the threads to know which recorder their cached buffer is from
+        std::atomic<bool> enabled;
+        Clock::time_point startTime;
+        std::ofstream file;
+        std::mutex buffersMutex; // Only locked when adding a buffer, naming a thread, or flushing
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        unsigned long long droppedEvents;
+};
+
+#endif
@@ -2,17 +2,22 @@
 // See the file LICENSE.txt for copying conditions.
 
 #include "accountdb.h"
+#include <utility>
 #include "packet.h"
 #include "configfile.h"
 
 const std::string AccountDb::accountListFilename = "accounts.txt";
+const std::string AccountDb::storeFilename = "accounts.dat";
+const std::string AccountDb::indexSnapshotFilename = "accounts.txt.snapshot";
 
-AccountDb::AccountDb()
+AccountDb::AccountDb():
+    indexSnapshot(true)
 {
     loadAccountList("accounts/");
 }
 
-AccountDb::AccountDb(const std::string& dir)
+AccountDb::AccountDb(const std::string& dir, bool indexSnapshot):
+    indexSnapshot(indexSnapshot)
 {
     loadAccountList(dir);
 }
@@ -21,7 +26,9 @@ bool AccountDb::loadAccountList(const std::string& dir)
 {
     accountDir = dir;
     strlib::mustEndWith(accountDir, "/");
-    return accountList.loadAccountIndex(accountDir + accountListFilename);
+    bool storeOpened = store.open(accountDir + storeFilename);
+    std::string snapshotFilename = (indexSnapshot ? accountDir + indexSnapshotFilename : "");
+    return (accountList.loadAccountIndex(accountDir + accountListFilename, snapshotFilename) && storeOpened);
 }
 
 int AccountDb::logIn(const std::string& username, const std::string& password, PlayerData& playerData)
@@ -30,15 +37,14 @@ int AccountDb::logIn(const std::string& username, const std::string& password, P
     int accountId = accountList.getAccountId(username); // Get the account ID from the username
     if (accountId > 0) // Make sure the account ID is valid
     {
-        std::string accountFilename = accountIdToFilename(accountId);
-        cfg::File accountCfg;
-        if (accountCfg.loadFromFile(accountFilename)) // Load the account config file
+        PlayerData accountData;
+        if (loadPlayerData(accountId, accountData)) // Load the account from the store
         {
-            if (accountCfg("password").toString() == password) // Check if the password is correct!
+            if (accountData.passwordHash == password) // Check if the password is correct!
             {
-                if (!accountCfg("banned").toBool()) // Check if the account is banned
+                if (!accountData.banned) // Check if the account is banned
                 {
-                    playerData.loadFromConfig(accountCfg); // Load the data from the config file into the player data object
+                    playerData = std::move(accountData);
                     playerData.username = username; // Make sure we set the username!
                     status = Packet::LogInCode::Successful;
                 }
@@ -64,11 +70,7 @@ int AccountDb::createAccount(const PlayerData& playerData)
         int newAccountId = accountList.addAccount(playerData.username); // Add the username to the account list and get its new ID
         if (newAccountId > 0) // If the account was added to the list successfully
         {
-            std::string accountFilename = accountIdToFilename(newAccountId);
-            cfg::File accountCfg;
-            playerData.saveToConfig(accountCfg); // Set the values in the config file in memory from the player data object
-
-            if (accountCfg.writeToFile(accountFilename)) // Write the account to a file
+            if (writePlayerData(newAccountId, playerData)) // Write the account to the store
                 status = Packet::CreateAccountCode::Successful;
         }
     }
@@ -82,13 +84,63 @@ bool AccountDb::saveAccount(const PlayerData& playerData)
     bool status = false;
     int accountId = accountList.getAccountId(playerData.username);
     if (accountId > 0)
+        status = writePlayerData(accountId, playerData);
+    return status;
+}
+
+unsigned AccountDb::saveAccounts(const std::vector<SavedAccount>& accounts)
+{
+    unsigned saved = 0;
+    for (auto& account: accounts)
     {
-        std::string accountFilename = accountIdToFilename(accountId);
-        cfg::File accountCfg;
-        playerData.saveToConfig(accountCfg); // Save the player data to a config file in memory
-        status = accountCfg.writeToFile(accountFilename); // Write the config file in memory to the file
+        int accountId = accountList.getAccountId(account.username);
+        if (accountId > 0 && store.append(accountId, account.data))
+            ++saved;
     }
-    return status;
+    if (!store.commit())
+        saved = 0;
+    return saved;
+}
+
+void AccountDb::setDurability(AccountStore::Durability durability)
+{
+    store.setDurability(durability);
+}
+
+bool AccountDb::needsCompaction() const
+{
+    return store.needsCompaction();
+}
+
+bool AccountDb::continueCompaction()
+{
+    return store.continueCompaction(compactionStep);
+}
+
+void AccountDb::compact()
+{
+    store.compact();
+}
+
+bool AccountDb::loadPlayerData(int accountId, PlayerData& playerData)
+{
+    if (store.contains(accountId))
+    {
+        sf::Packet data;
+        return (store.read(accountId, data) && playerData.loadFromPacket(data));
+    }
+    cfg::File accountCfg;
+    if (!accountCfg.loadFromFile(accountIdToFilename(accountId))) // Load the old account config file
+        return false;
+    playerData.loadFromConfig(accountCfg); // Load the data from the config file into the player data object
+    return true;
+}
+
+bool AccountDb::writePlayerData(int accountId, const PlayerData& playerData)
+{
+    sf::Packet data;
+    playerData.saveToPacket(data);
+    return store.write(accountId, data);
 }
 
 std::string AccountDb::accountIdToFilename(int id)
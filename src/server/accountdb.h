@@ -4,8 +4,12 @@
 #ifndef ACCOUNTDB_H
 #define ACCOUNTDB_H
 
+#include <string>
+#include <vector>
+#include <SFML/Network.hpp>
 #include "playerdata.h"
 #include "accountindex.h"
+#include "accountstore.h"
 
 /*
 TODO:
@@ -13,23 +17,23 @@ TODO:
 */
 
 /*
-This class will temporarily be used as the account database for the game server.
-It relies on the ConfigFile class for storing each account in a separate file.
+This class is the account database for the game server.
+It relies on the AccountStore class for storing the data of every account in a single binary file.
 It relies on the AccountIndex class for storing a list of all of the accounts.
-It probably isn't the best thing to use, but it will be good enough for now, and will simplify debugging as
-    all of the accounts are just plain text files that can easily be edited.
 
 The directory/file structure looks like this:
 accounts/
     accounts.txt // Stores a list of usernames and account IDs
-    1.txt // Named as account ID; starts at 1, not 0
-    2.txt
-    3.txt
+    accounts.txt.snapshot // The loaded form of accounts.txt, so it doesn't need to be parsed again (optional)
+    accounts.dat // The account store, with the player data of each account ID
+    accounts.dat.checkpoint // Where each account is in the store, so it opens quickly
+    1.txt // Accounts from before the account store, named as account ID; starts at 1, not 0
 
-Only accounts.txt is loaded into RAM, the rest is loaded/saved on demand.
+Only the account index and the store's offsets are loaded into RAM, the player data is loaded/saved on demand.
 As new accounts are created, the account ID increments each time.
     The account is also added to the accounts.txt file.
 The main reason for using account IDs instead of just usernames is to allow more symbols in usernames.
+An account that only has an old text file is still loaded from it, and goes into the store the next time it's saved.
 
 Accounts.txt:
     test
@@ -42,21 +46,42 @@ Accounts.txt:
 class AccountDb
 {
     public:
+        // A player's data that is already in the account store's binary form
+        struct SavedAccount
+        {
+            std::string username;
+            sf::Packet data;
+        };
+
         AccountDb(); // Uses default account directory
-        AccountDb(const std::string&); // Takes directory of accounts
+        AccountDb(const std::string&, bool = true); // Takes directory of accounts, and whether to keep a snapshot of accounts.txt
         bool loadAccountList(const std::string&); // Same as constructor
 
         int logIn(const std::string&, const std::string&, PlayerData&); // Username, password, player data object to load into
         int createAccount(const PlayerData&); // Player data object to read from (username and password are stored in here)
         bool saveAccount(const PlayerData&); // Reads from the player data object and writes the account file
+        unsigned saveAccounts(const std::vector<SavedAccount>&); // Commits them all at once, returns how many were saved
+        void setDurability(AccountStore::Durability);
+
+        // Saves only append to the store, so the old records need to be cleaned up once in a while
+        bool needsCompaction() const;
+        bool continueCompaction(); // Does a small part of it, returns true once it's over
+        void compact(); // Does all of it at once
 
     private:
         std::string accountIdToFilename(int);
+        bool loadPlayerData(int, PlayerData&); // From the store, or from the old text file if it isn't in there
+        bool writePlayerData(int, const PlayerData&);
 
         std::string accountDir;
         static const std::string accountListFilename;
+        static const std::string storeFilename;
+        static const std::string indexSnapshotFilename;
+        static const unsigned compactionStep = 256; // Records copied by each call to continueCompaction
 
         AccountIndex accountList; // Stores a list of usernames and account IDs
+        AccountStore store; // Stores the player data of each account
+        bool indexSnapshot;
 
 };
 
@@ -2,64 +2,162 @@
 // See the file LICENSE.txt for copying conditions.
 
 #include "accountindex.h"
-#include <sstream>
 #include <fstream>
-#include "configoption.h"
+#include <cstring>
+#include <cstdio>
+#include "mappedfile.h"
 
-IntString::IntString(): num(0) {}
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
 
-IntString& IntString::operator=(const std::string& data)
+// FNV-1a, which can continue from a previous hash
+static sf::Uint64 hashBytes(const char* data, std::size_t size, sf::Uint64 hash = 14695981039346656037ull)
 {
-    // Always set the string, but set the number to 0 if it fails
-    str = data;
-    std::istringstream tmp(data);
-    if (!(tmp >> num))
-        num = 0;
-    /*
-    // If it fails then change nothing
-    istringstream tmp(data);
-    if (tmp >> num)
-        str = data;
-    */
-    return *this;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Returns the ID on a line, or 0 if it isn't a number
+static int parseId(const char* start, const char* end)
+{
+    if (end > start && end[-1] == '\r')
+        --end;
+    int id = 0;
+    const char* c = start;
+    for (; c < end && *c >= '0' && *c <= '9'; ++c)
+        id = id * 10 + (*c - '0');
+    return (c == end ? id : 0);
+}
+
+// Cuts off the end of a file
+static bool truncateFile(const std::string& filename, sf::Uint64 size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER position;
+    position.QuadPart = size;
+    bool truncated = (SetFilePointerEx(file, position, nullptr, FILE_BEGIN) != 0 && SetEndOfFile(file) != 0);
+    CloseHandle(file);
+    return truncated;
+#else
+    return (truncate(filename.c_str(), static_cast<off_t>(size)) == 0);
+#endif
+}
+
+static sf::Uint32 hashName(const char* name, std::size_t length)
+{
+    sf::Uint64 hash = hashBytes(name, length);
+    return static_cast<sf::Uint32>(hash ^ (hash >> 32));
+}
+
+static void putUint32(std::vector<char>& bytes, sf::Uint32 value)
+{
+    for (int i = 0; i < 4; ++i)
+        bytes.push_back(static_cast<char>(value >> (i * 8)));
+}
+
+static void putUint64(std::vector<char>& bytes, sf::Uint64 value)
+{
+    for (int i = 0; i < 8; ++i)
+        bytes.push_back(static_cast<char>(value >> (i * 8)));
+}
+
+static sf::Uint32 getUint32(const char* bytes)
+{
+    sf::Uint32 value = 0;
+    for (int i = 0; i < 4; ++i)
+        value |= static_cast<sf::Uint32>(static_cast<unsigned char>(bytes[i])) << (i * 8);
+    return value;
+}
+
+static sf::Uint64 getUint64(const char* bytes)
+{
+    return getUint32(bytes) | (static_cast<sf::Uint64>(getUint32(bytes + 4)) << 32);
 }
 
 AccountIndex::AccountIndex()
 {
-    numOfAccounts = 0;
+    clear();
+}
+
+AccountIndex::~AccountIndex()
+{
+    if (snapshotChanged && !snapshotFilename.empty())
+        saveSnapshot();
 }
 
-bool AccountIndex::loadAccountIndex(const std::string& filename)
+bool AccountIndex::loadAccountIndex(const std::string& filename, const std::string& newSnapshotFilename)
 {
-    //cout << "loadAccountIndex()...\n";
     indexFilename = filename;
-    bool status = false;
-    std::ifstream file(filename, std::ifstream::in); // Open the file
-    if (file.is_open())
+    snapshotFilename = newSnapshotFilename;
+    clear();
+    MappedFile file;
+    if (!file.open(filename))
+        return false;
+
+    // Only the accounts added after the snapshot need to be parsed
+    if (snapshotFilename.empty() || !loadSnapshot(file))
+        clear();
+    sf::Uint64 loadedSize = textSize;
+    std::size_t used = parse(file.getData() + textSize, file.getSize() - textSize);
+    textHash = hashBytes(file.getData() + textSize, used, textHash);
+    textSize += used;
+    std::string tail(file.getData() + textSize, file.getSize() - textSize);
+    file.close(); // So the file can be changed on Windows
+    if (!tail.empty() && !repairTail(tail))
+        return false;
+    snapshotChanged = (textSize > loadedSize);
+    if (snapshotChanged && !snapshotFilename.empty())
+        saveSnapshot();
+    return true;
+}
+
+bool AccountIndex::saveSnapshot()
+{
+    if (snapshotFilename.empty())
+        return false;
+    std::vector<char> bytes = {'U', 'M', 'X', snapshotVersion};
+    bytes.reserve(snapshotHeaderSize + names.size() + slots.size() * sizeof(Slot));
+    putUint64(bytes, textSize);
+    putUint64(bytes, textHash);
+    putUint32(bytes, numOfAccounts);
+    putUint32(bytes, count);
+    putUint32(bytes, names.size());
+    putUint32(bytes, slots.size());
+    bytes.insert(bytes.end(), names.begin(), names.end());
+    for (auto& slot: slots)
     {
-        bool good = true;
-        std::string username, accountId;
-        IntString maxNum;
-        while (good && getline(file, username)) // Read a line
-        {
-            if (getline(file, accountId)) // Read a 2nd line
-            {
-                if (!username.empty() && !accountId.empty()) // Ignore any empty lines
-                {
-                    //cout << "Username: " << username << ", ID: " << accountId << endl;
-                    index[username] = accountId; // Store the account ID in memory
-                    maxNum = accountId;
-                    if (maxNum.num > numOfAccounts) // If this account ID is greater than the current maximum ID
-                        numOfAccounts = maxNum.num; // Then save this as the number of accounts
-                    // By doing this, it supports out-of-order account indexes, rather than just storing the last account ID
-                }
-            }
-            else
-                good = false;
-        }
-        status = true;
+        putUint32(bytes, slot.nameOffset);
+        putUint32(bytes, slot.nameLength);
+        putUint32(bytes, slot.accountId);
+        putUint32(bytes, slot.hash);
+    }
+
+    // Write to a temporary file first, so the old snapshot is still there if this fails
+    std::string tempFilename = snapshotFilename + ".tmp";
+    std::ofstream out(tempFilename, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size());
+    out.close();
+    if (!out)
+        return false;
+    if (std::rename(tempFilename.c_str(), snapshotFilename.c_str()) != 0)
+    {
+        std::remove(snapshotFilename.c_str());
+        if (std::rename(tempFilename.c_str(), snapshotFilename.c_str()) != 0)
+            return false;
     }
-    return status;
+    snapshotChanged = false;
+    return true;
 }
 
 // This adds an account to the list, and automatically assigns an account ID.
@@ -67,16 +165,19 @@ bool AccountIndex::loadAccountIndex(const std::string& filename)
 int AccountIndex::addAccount(const std::string& username)
 {
     int id = -1;
-    if (getAccountId(username) == -1) // Only add the account if it does not already exist
+    if (!username.empty() && getAccountId(username) == -1) // Only add the account if it does not already exist
     {
         std::ofstream outFile(indexFilename, std::ofstream::out | std::ofstream::app);
         if (outFile.is_open())
         {
             numOfAccounts++; // Generate a new account ID
-            std::string idStr = std::to_string(numOfAccounts);
-            index[username] = idStr; // Store the new account in memory
-            outFile << username + '\n' + idStr + '\n'; // Append the username and ID to the file
+            std::string lines = username + '\n' + std::to_string(numOfAccounts) + '\n';
+            outFile << lines; // Append the username and ID to the file
             outFile.close();
+            insert(username.data(), username.size(), numOfAccounts); // Store the new account in memory
+            textHash = hashBytes(lines.data(), lines.size(), textHash);
+            textSize += lines.size();
+            snapshotChanged = true;
             id = numOfAccounts; // Set the return value to the new ID
         }
     }
@@ -85,11 +186,187 @@ int AccountIndex::addAccount(const std::string& username)
 
 // Returns the account ID of the username passed in
 // If it does not exist, then it returns -1
-int AccountIndex::getAccountId(const std::string& username)
+int AccountIndex::getAccountId(const std::string& username) const
 {
-    int id = -1;
-    auto found = index.find(username);
-    if (found != index.end())
-        id = found->second.num;
-    return id;
+    const Slot* slot = find(username.data(), username.size(), hashName(username.data(), username.size()));
+    return (slot != nullptr ? slot->accountId : -1);
+}
+
+unsigned AccountIndex::getAccountCount() const
+{
+    return count;
+}
+
+void AccountIndex::clear()
+{
+    numOfAccounts = 0;
+    count = 0;
+    names.clear();
+    slots.assign(16, Slot{0, 0, 0, 0});
+    textSize = 0;
+    textHash = hashBytes(nullptr, 0);
+    snapshotChanged = false;
+}
+
+void AccountIndex::insert(const char* name, std::size_t length, int accountId)
+{
+    sf::Uint32 hash = hashName(name, length);
+    Slot* existing = const_cast<Slot*>(find(name, length, hash));
+    if (existing != nullptr)
+    {
+        existing->accountId = accountId;
+        return;
+    }
+    // Keep the table at most 70% full, so the probes stay short
+    if ((count + 1) * 10 > slots.size() * 7)
+        grow();
+    std::size_t mask = slots.size() - 1;
+    std::size_t i = hash & mask;
+    while (slots[i].accountId != 0)
+        i = (i + 1) & mask;
+    slots[i] = Slot{static_cast<sf::Uint32>(names.size()), static_cast<sf::Uint32>(length), accountId, hash};
+    names.insert(names.end(), name, name + length);
+    ++count;
+}
+
+const AccountIndex::Slot* AccountIndex::find(const char* name, std::size_t length, sf::Uint32 hash) const
+{
+    std::size_t mask = slots.size() - 1;
+    for (std::size_t i = hash & mask; slots[i].accountId != 0; i = (i + 1) & mask)
+    {
+        const Slot& slot = slots[i];
+        if (slot.hash == hash && slot.nameLength == length && std::memcmp(names.data() + slot.nameOffset, name, length) == 0)
+            return &slot;
+    }
+    return nullptr;
+}
+
+void AccountIndex::grow()
+{
+    std::vector<Slot> oldSlots(slots.size() * 2, Slot{0, 0, 0, 0});
+    oldSlots.swap(slots);
+    std::size_t mask = slots.size() - 1;
+    for (auto& slot: oldSlots)
+    {
+        if (slot.accountId != 0)
+        {
+            std::size_t i = slot.hash & mask;
+            while (slots[i].accountId != 0)
+                i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+    }
+}
+
+std::size_t AccountIndex::parse(const char* data, std::size_t size)
+{
+    const char* end = data + size;
+    const char* pos = data;
+    const char* used = data;
+    while (pos < end)
+    {
+        // Skip any empty lines between the pairs
+        if (*pos == '\n' || *pos == '\r')
+        {
+            used = ++pos;
+            continue;
+        }
+
+        // Find the username line and the ID line after it
+        const char* username = pos;
+        const char* usernameEnd = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+        if (usernameEnd == nullptr || usernameEnd + 1 == end)
+            break; // The ID line is missing
+        const char* idStart = usernameEnd + 1;
+        const char* idEnd = static_cast<const char*>(std::memchr(idStart, '\n', end - idStart));
+        if (idEnd == nullptr)
+            break; // The ID line isn't finished
+        pos = idEnd + 1;
+        used = pos;
+
+        std::size_t usernameLength = usernameEnd - username;
+        if (usernameLength > 0 && username[usernameLength - 1] == '\r')
+            --usernameLength;
+        int id = parseId(idStart, idEnd);
+        if (usernameLength > 0 && id > 0)
+        {
+            insert(username, usernameLength, id);
+            if (id > numOfAccounts) // If this account ID is greater than the current maximum ID
+                numOfAccounts = id; // Then save this as the number of accounts
+            // By doing this, it supports out-of-order account indexes, rather than just storing the last account ID
+        }
+    }
+    return used - data;
+}
+
+bool AccountIndex::repairTail(const std::string& tail)
+{
+    // The last line can be missing its newline if accounts.txt was edited by hand.
+    // A write that was cut off can look the same, but then the ID is cut short, so it's lower than an ID before it.
+    std::size_t usernameEnd = tail.find('\n');
+    if (usernameEnd != std::string::npos && usernameEnd > 0 &&
+        parseId(tail.data() + usernameEnd + 1, tail.data() + tail.size()) > numOfAccounts)
+    {
+        std::ofstream outFile(indexFilename, std::ofstream::out | std::ofstream::app);
+        outFile << '\n';
+        outFile.close();
+        if (outFile)
+        {
+            std::string lines = tail + '\n';
+            parse(lines.data(), lines.size());
+            textHash = hashBytes(lines.data(), lines.size(), textHash);
+            textSize += lines.size();
+            return true;
+        }
+    }
+
+    // Otherwise the incomplete pair is cut off, so the next account isn't added onto it
+    return truncateFile(indexFilename, textSize);
+}
+
+bool AccountIndex::loadSnapshot(const MappedFile& textFile)
+{
+    MappedFile file;
+    if (!file.open(snapshotFilename) || file.getSize() < snapshotHeaderSize)
+        return false;
+    const char* data = file.getData();
+    if (std::memcmp(data, "UMX", 3) != 0 || data[3] != snapshotVersion)
+        return false;
+    sf::Uint64 snapshotTextSize = getUint64(data + 4);
+    sf::Uint64 snapshotTextHash = getUint64(data + 12);
+    sf::Int32 maxId = getUint32(data + 20);
+    sf::Uint32 snapshotCount = getUint32(data + 24);
+    sf::Uint32 namesSize = getUint32(data + 28);
+    sf::Uint32 slotCount = getUint32(data + 32);
+    if (slotCount < 16 || (slotCount & (slotCount - 1)) != 0 || snapshotCount >= slotCount ||
+        file.getSize() != snapshotHeaderSize + namesSize + slotCount * 16ull)
+        return false;
+
+    // The snapshot is only good if accounts.txt still starts with what it was made from
+    if (snapshotTextSize > textFile.getSize() || hashBytes(textFile.getData(), snapshotTextSize) != snapshotTextHash)
+        return false;
+
+    names.assign(data + snapshotHeaderSize, data + snapshotHeaderSize + namesSize);
+    slots.resize(slotCount);
+    const char* slotData = data + snapshotHeaderSize + namesSize;
+    sf::Uint32 usedSlots = 0;
+    for (auto& slot: slots)
+    {
+        slot.nameOffset = getUint32(slotData);
+        slot.nameLength = getUint32(slotData + 4);
+        slot.accountId = getUint32(slotData + 8);
+        slot.hash = getUint32(slotData + 12);
+        if (static_cast<sf::Uint64>(slot.nameOffset) + slot.nameLength > namesSize)
+            return false;
+        if (slot.accountId != 0)
+            ++usedSlots;
+        slotData += 16;
+    }
+    if (usedSlots != snapshotCount)
+        return false; // The lookups need empty slots to stop at
+    numOfAccounts = maxId;
+    count = snapshotCount;
+    textSize = snapshotTextSize;
+    textHash = snapshotTextHash;
+    return true;
 }
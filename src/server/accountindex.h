@@ -5,33 +5,65 @@
 #define ACCOUNTINDEX_H
 
 #include <string>
-#include <map>
+#include <vector>
+#include <SFML/Config.hpp>
 
-// A lightweight "Option"-like class
-class IntString
-{
-    public:
-        IntString();
-        IntString& operator=(const std::string&);
-
-        int num;
-        std::string str;
-};
+class MappedFile;
 
-// This class manages a list of account usernames, and was made only for performance improvements because of ConfigFile's slow file writing
+/*
+This class manages a list of account usernames and IDs, which is stored in accounts.txt.
+The usernames are each stored once in a single block of memory, and found with an open addressing hash table.
+    The table only has offsets into that block, so each account only costs a few numbers plus its username.
+accounts.txt is loaded by mapping it into memory and parsing it in one pass.
+    New accounts are appended to it, so it never has to be rewritten.
+    If it ends with an incomplete pair (from a write that was cut off), that is cut off when it's loaded,
+        so new accounts always start on a line of their own.
+The table can also be saved as a binary snapshot, which loads without parsing or hashing any usernames.
+    The snapshot has the size and a hash of the part of accounts.txt that it came from,
+        so it's only used if accounts.txt still starts with that, and anything after it gets parsed like normal.
+    A new snapshot is saved when the old one was out of date, and when accounts were added before this is destroyed.
+*/
 class AccountIndex
 {
     public:
         AccountIndex();
-        bool loadAccountIndex(const std::string&); // filename (accounts.txt)
+        ~AccountIndex();
+        bool loadAccountIndex(const std::string&, const std::string& = ""); // filename (accounts.txt), and snapshot filename (optional)
+        bool saveSnapshot();
 
         int addAccount(const std::string&); // takes username, returns account ID
-        int getAccountId(const std::string&); // takes username, returns account ID
+        int getAccountId(const std::string&) const; // takes username, returns account ID
+        unsigned getAccountCount() const;
 
     private:
+        struct Slot
+        {
+            sf::Uint32 nameOffset; // Where the username is in the names
+            sf::Uint32 nameLength;
+            sf::Int32 accountId; // 0 if the slot is empty
+            sf::Uint32 hash;
+        };
+
+        static const char snapshotVersion = 1;
+        static const std::size_t snapshotHeaderSize = 36;
+
+        void clear();
+        void insert(const char* name, std::size_t length, int accountId); // Replaces the ID if the username was already there
+        const Slot* find(const char* name, std::size_t length, sf::Uint32 hash) const;
+        void grow();
+        std::size_t parse(const char* data, std::size_t size); // Parses pairs of username and ID lines, returns the bytes used
+        bool repairTail(const std::string& tail); // Finishes or cuts off what's after the last complete pair
+        bool loadSnapshot(const MappedFile& textFile);
+
         std::string indexFilename;
-        int numOfAccounts;
-        std::map<std::string,IntString> index;
+        std::string snapshotFilename;
+        int numOfAccounts; // The highest account ID
+        unsigned count;
+        std::vector<char> names;
+        std::vector<Slot> slots; // The size is always a power of 2
+        sf::Uint64 textSize; // Bytes of accounts.txt that have been loaded or added
+        sf::Uint64 textHash; // Hash of those bytes, to tell if a snapshot still matches accounts.txt
+        bool snapshotChanged; // If the snapshot doesn't have everything in the index
 };
 
 #endif
@@ -0,0 +1,549 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "accountstore.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+static sf::Uint32 crc32(sf::Uint32 crc, const char* data, std::size_t size)
+{
+    static const std::array<sf::Uint32, 256> table = []()
+    {
+        std::array<sf::Uint32, 256> newTable;
+        for (sf::Uint32 i = 0; i < 256; ++i)
+        {
+            sf::Uint32 value = i;
+            for (int bit = 0; bit < 8; ++bit)
+                value = (value & 1 ? 0xEDB88320 ^ (value >> 1) : value >> 1);
+            newTable[i] = value;
+        }
+        return newTable;
+    }();
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void putUint32(std::vector<char>& bytes, sf::Uint32 value)
+{
+    for (int i = 0; i < 4; ++i)
+        bytes.push_back(static_cast<char>(value >> (i * 8)));
+}
+
+static void putUint64(std::vector<char>& bytes, sf::Uint64 value)
+{
+    for (int i = 0; i < 8; ++i)
+        bytes.push_back(static_cast<char>(value >> (i * 8)));
+}
+
+static sf::Uint32 getUint32(const char* bytes)
+{
+    sf::Uint32 value = 0;
+    for (int i = 0; i < 4; ++i)
+        value |= static_cast<sf::Uint32>(static_cast<unsigned char>(bytes[i])) << (i * 8);
+    return value;
+}
+
+static sf::Uint64 getUint64(const char* bytes)
+{
+    return getUint32(bytes) | (static_cast<sf::Uint64>(getUint32(bytes + 4)) << 32);
+}
+
+// Makes sure everything written to a file is on the disk, and not just in the operating system's cache
+static bool syncFile(const std::string& filename)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    bool synced = (FlushFileBuffers(file) != 0);
+    CloseHandle(file);
+    return synced;
+#else
+    int file = open(filename.c_str(), O_RDONLY);
+    if (file == -1)
+        return false;
+    bool synced = (fsync(file) == 0);
+    close(file);
+    return synced;
+#endif
+}
+
+// Renames over an existing file, which std::rename can't do on some platforms
+static bool replaceFile(const std::string& from, const std::string& to)
+{
+    if (std::rename(from.c_str(), to.c_str()) == 0)
+        return true;
+    std::remove(to.c_str());
+    return (std::rename(from.c_str(), to.c_str()) == 0);
+}
+
+AccountStore::AccountStore():
+    durability(Flushed),
+    generation(0),
+    fileSize(0),
+    liveBytes(0),
+    recordCount(0),
+    sinceCheckpoint(0),
+    compacting(false),
+    compactionNextId(0),
+    compactedSize(0),
+    retryCompactionSize(0)
+{
+}
+
+AccountStore::~AccountStore()
+{
+    cancelCompaction();
+    if (isOpen() && sinceCheckpoint > 0)
+        writeCheckpoint();
+}
+
+bool AccountStore::open(const std::string& newFilename)
+{
+    cancelCompaction();
+    retryCompactionSize = 0;
+    filename = newFilename;
+    file.close();
+    file.clear();
+    entries.clear();
+    liveBytes = 0;
+    recordCount = 0;
+    sinceCheckpoint = 0;
+    file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file.is_open())
+        return create();
+    file.seekg(0, std::ios::end);
+    fileSize = file.tellg();
+    if (fileSize == 0)
+    {
+        // The server stopped before it even wrote the header
+        file.close();
+        return create();
+    }
+
+    char header[headerSize];
+    file.seekg(0);
+    if (!file.read(header, headerSize) || std::memcmp(header, "UMA", 3) != 0 || header[3] != version)
+    {
+        // Don't write over something that isn't an account store
+        file.close();
+        return false;
+    }
+    generation = getUint32(header + 4);
+
+    sf::Uint64 scanOffset = headerSize;
+    if (!loadCheckpoint(scanOffset))
+    {
+        entries.clear();
+        liveBytes = 0;
+        recordCount = 0;
+        scanOffset = headerSize;
+    }
+    scan(scanOffset);
+    return true;
+}
+
+bool AccountStore::isOpen() const
+{
+    return file.is_open();
+}
+
+bool AccountStore::contains(int accountId) const
+{
+    return (accountId > 0 && static_cast<unsigned>(accountId) < entries.size() && entries[accountId].offset != 0);
+}
+
+bool AccountStore::read(int accountId, sf::Packet& data)
+{
+    sf::Int32 storedId;
+    if (!contains(accountId) || !readRecord(entries[accountId].offset, storedId, buffer) || storedId != accountId)
+        return false;
+    data.clear();
+    data.append(buffer.data(), buffer.size());
+    return true;
+}
+
+bool AccountStore::write(int accountId, const sf::Packet& data)
+{
+    return (append(accountId, data) && commit());
+}
+
+bool AccountStore::append(int accountId, const sf::Packet& data)
+{
+    if (!isOpen() || accountId <= 0)
+        return false;
+    file.seekp(fileSize);
+    if (!writeRecord(file, accountId, data.getData(), data.getDataSize()))
+    {
+        // Anything that made it into the file is past the end, so it will be written over by the next record
+        file.clear();
+        return false;
+    }
+    sf::Uint32 size = recordHeaderSize + data.getDataSize();
+    setEntry(accountId, fileSize, size);
+    fileSize += size;
+    if (++sinceCheckpoint >= checkpointInterval)
+        writeCheckpoint();
+    return true;
+}
+
+bool AccountStore::commit()
+{
+    if (!isOpen())
+        return false;
+    if (durability == Buffered)
+        return true;
+    if (!file.flush())
+    {
+        file.clear();
+        return false;
+    }
+    return (durability != Synced || syncFile(filename));
+}
+
+void AccountStore::setDurability(Durability newDurability)
+{
+    durability = newDurability;
+}
+
+bool AccountStore::needsCompaction() const
+{
+    if (compacting)
+        return true;
+    return (fileSize >= minCompactionSize && fileSize >= retryCompactionSize && fileSize - headerSize - liveBytes > liveBytes);
+}
+
+bool AccountStore::compact()
+{
+    if (!compacting && !startCompaction())
+        return false;
+    return (copyRecords(entries.size()) && finishCompaction());
+}
+
+bool AccountStore::continueCompaction(unsigned maxRecords)
+{
+    if (!compacting && !startCompaction())
+        return true;
+    if (!copyRecords(maxRecords))
+        return true;
+    if (compactionNextId < entries.size())
+        return false;
+    finishCompaction();
+    return true;
+}
+
+void AccountStore::cancelCompaction()
+{
+    if (compacting)
+    {
+        compactedFile.close();
+        std::remove(getTempFilename().c_str());
+        compacting = false;
+    }
+}
+
+bool AccountStore::startCompaction()
+{
+    if (!isOpen())
+    {
+        retryCompactionSize = fileSize + minCompactionSize;
+        return false;
+    }
+    compactedFile.clear();
+    compactedFile.open(getTempFilename(), std::ios::binary | std::ios::trunc);
+    std::vector<char> header = {'U', 'M', 'A', version};
+    putUint32(header, generation + 1);
+    compactedFile.write(header.data(), header.size());
+    if (!compactedFile)
+    {
+        compacting = true;
+        failCompaction();
+        return false;
+    }
+    compacting = true;
+    compactionNextId = 1;
+    compactedSize = headerSize;
+    compactedEntries.assign(entries.size(), Entry{0, 0});
+    copiedFrom.assign(entries.size(), 0);
+    return true;
+}
+
+bool AccountStore::copyRecords(unsigned maxRecords)
+{
+    // Only the newest record of each account is copied
+    // (Accounts added since the compaction started are past the old end, so they still get copied)
+    unsigned copied = 0;
+    for (; compactionNextId < entries.size() && copied < maxRecords; ++compactionNextId)
+    {
+        if (entries[compactionNextId].offset != 0)
+        {
+            if (!copyRecord(compactionNextId))
+                return false;
+            ++copied;
+        }
+    }
+    return true;
+}
+
+bool AccountStore::copyRecord(unsigned accountId)
+{
+    sf::Int32 storedId;
+    const Entry& entry = entries[accountId];
+    if (!readRecord(entry.offset, storedId, buffer) || storedId != static_cast<sf::Int32>(accountId))
+        return true; // It was never a valid record, so there's nothing to keep
+    if (!writeRecord(compactedFile, accountId, buffer.data(), buffer.size()))
+    {
+        failCompaction();
+        return false;
+    }
+    if (accountId >= compactedEntries.size())
+    {
+        compactedEntries.resize(accountId + 1, Entry{0, 0});
+        copiedFrom.resize(accountId + 1, 0);
+    }
+    compactedEntries[accountId] = Entry{compactedSize, entry.size};
+    copiedFrom[accountId] = entry.offset;
+    compactedSize += entry.size;
+    return true;
+}
+
+bool AccountStore::finishCompaction()
+{
+    // Anything written after its account was passed gets copied now, and an earlier copy is left as an old record
+    copiedFrom.resize(entries.size(), 0);
+    for (unsigned id = 1; id < entries.size(); ++id)
+    {
+        if (entries[id].offset != 0 && entries[id].offset != copiedFrom[id] && !copyRecord(id))
+            return false;
+    }
+    std::string tempFilename = getTempFilename();
+    compactedFile.close();
+    if (!compactedFile || (durability == Synced && !syncFile(tempFilename)))
+    {
+        failCompaction();
+        return false;
+    }
+    compacting = false;
+
+    // The old file stays complete until the new one replaces it
+    file.close();
+    bool replaced = replaceFile(tempFilename, filename);
+    file.clear();
+    file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+    if (!replaced || !file.is_open())
+    {
+        std::remove(tempFilename.c_str());
+        bool reopened = (file.is_open() && open(filename)); // Fall back to whatever file is there now
+        if (!replaced)
+            retryCompactionSize = fileSize + minCompactionSize;
+        return reopened;
+    }
+    generation = generation + 1;
+    compactedEntries.resize(entries.size(), Entry{0, 0});
+    entries.swap(compactedEntries);
+    fileSize = compactedSize;
+    liveBytes = 0;
+    recordCount = 0;
+    for (auto& entry: entries)
+    {
+        if (entry.offset != 0)
+        {
+            liveBytes += entry.size;
+            ++recordCount;
+        }
+    }
+    compactedEntries.clear();
+    copiedFrom.clear();
+    retryCompactionSize = 0;
+    return writeCheckpoint();
+}
+
+void AccountStore::failCompaction()
+{
+    cancelCompaction();
+    compactedEntries.clear();
+    copiedFrom.clear();
+    retryCompactionSize = fileSize + minCompactionSize;
+}
+
+bool AccountStore::writeCheckpoint()
+{
+    // The checkpoint can't point to records that could still be lost
+    if (!isOpen() || !file.flush() || (durability == Synced && !syncFile(filename)))
+    {
+        file.clear();
+        return false;
+    }
+    std::vector<char> bytes = {'U', 'M', 'C', version};
+    bytes.reserve(32 + entries.size() * 12);
+    putUint32(bytes, generation);
+    putUint64(bytes, fileSize);
+    putUint64(bytes, liveBytes);
+    putUint32(bytes, entries.size());
+    for (auto& entry: entries)
+    {
+        putUint64(bytes, entry.offset);
+        putUint32(bytes, entry.size);
+    }
+    putUint32(bytes, crc32(0, bytes.data(), bytes.size()));
+
+    std::string checkpointFilename = getCheckpointFilename();
+    std::string tempFilename = checkpointFilename + ".tmp";
+    std::ofstream out(tempFilename, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size());
+    out.close();
+    if (!out || (durability == Synced && !syncFile(tempFilename)) || !replaceFile(tempFilename, checkpointFilename))
+        return false;
+    sinceCheckpoint = 0;
+    return true;
+}
+
+unsigned AccountStore::getRecordCount() const
+{
+    return recordCount;
+}
+
+sf::Uint64 AccountStore::getFileSize() const
+{
+    return fileSize;
+}
+
+sf::Uint64 AccountStore::getLiveBytes() const
+{
+    return liveBytes;
+}
+
+bool AccountStore::create()
+{
+    file.clear();
+    file.open(filename, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+    generation = 1;
+    std::vector<char> header = {'U', 'M', 'A', version};
+    putUint32(header, generation);
+    file.write(header.data(), header.size());
+    file.flush();
+    fileSize = headerSize;
+    std::remove(getCheckpointFilename().c_str()); // In case it was left from an older store
+    return static_cast<bool>(file);
+}
+
+bool AccountStore::loadCheckpoint(sf::Uint64& coveredSize)
+{
+    std::ifstream in(getCheckpointFilename(), std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const std::size_t fixedSize = 4 + 4 + 8 + 8 + 4;
+    if (bytes.size() < fixedSize + 4 || std::memcmp(bytes.data(), "UMC", 3) != 0 || bytes[3] != version)
+        return false;
+    if (crc32(0, bytes.data(), bytes.size() - 4) != getUint32(bytes.data() + bytes.size() - 4))
+        return false;
+    sf::Uint32 checkpointGeneration = getUint32(&bytes[4]);
+    coveredSize = getUint64(&bytes[8]);
+    sf::Uint64 checkpointLiveBytes = getUint64(&bytes[16]);
+    sf::Uint32 count = getUint32(&bytes[24]);
+    if (checkpointGeneration != generation || coveredSize > fileSize || coveredSize < headerSize ||
+        bytes.size() != fixedSize + count * 12ull + 4)
+        return false;
+
+    entries.resize(count);
+    const char* entryBytes = &bytes[fixedSize];
+    recordCount = 0;
+    for (auto& entry: entries)
+    {
+        entry.offset = getUint64(entryBytes);
+        entry.size = getUint32(entryBytes + 8);
+        if (entry.offset != 0)
+            ++recordCount;
+        entryBytes += 12;
+    }
+    liveBytes = checkpointLiveBytes;
+    return true;
+}
+
+void AccountStore::scan(sf::Uint64 offset)
+{
+    sf::Int32 accountId;
+    while (offset + recordHeaderSize <= fileSize && readRecord(offset, accountId, buffer))
+    {
+        sf::Uint32 size = recordHeaderSize + buffer.size();
+        if (accountId > 0)
+            setEntry(accountId, offset, size);
+        offset += size;
+    }
+    // A cut off record at the end gets written over by the next one
+    fileSize = offset;
+    file.clear();
+}
+
+bool AccountStore::readRecord(sf::Uint64 offset, sf::Int32& accountId, std::vector<char>& data)
+{
+    char header[recordHeaderSize];
+    file.clear();
+    file.seekg(offset);
+    if (!file.read(header, recordHeaderSize))
+        return false;
+    sf::Uint32 size = getUint32(header);
+    sf::Uint32 checksum = getUint32(header + 4);
+    if (size > maxRecordSize || offset + recordHeaderSize + size > fileSize)
+        return false;
+    data.resize(size);
+    if (size > 0 && !file.read(data.data(), size))
+        return false;
+    if (crc32(crc32(0, header + 8, 4), data.data(), size) != checksum)
+        return false;
+    accountId = static_cast<sf::Int32>(getUint32(header + 8));
+    return true;
+}
+
+void AccountStore::setEntry(int accountId, sf::Uint64 offset, sf::Uint32 size)
+{
+    if (static_cast<unsigned>(accountId) >= entries.size())
+        entries.resize(accountId + 1, Entry{0, 0});
+    Entry& entry = entries[accountId];
+    if (entry.offset != 0)
+        liveBytes -= entry.size;
+    else
+        ++recordCount;
+    entry.offset = offset;
+    entry.size = size;
+    liveBytes += size;
+}
+
+bool AccountStore::writeRecord(std::ostream& out, int accountId, const void* data, std::size_t size)
+{
+    std::vector<char> header;
+    header.reserve(recordHeaderSize);
+    putUint32(header, size);
+    putUint32(header, 0); // The checksum goes here once the ID is in place
+    putUint32(header, accountId);
+    sf::Uint32 checksum = crc32(crc32(0, &header[8], 4), static_cast<const char*>(data), size);
+    for (int i = 0; i < 4; ++i)
+        header[4 + i] = static_cast<char>(checksum >> (i * 8));
+    out.write(header.data(), header.size());
+    if (size > 0)
+        out.write(static_cast<const char*>(data), size);
+    return static_cast<bool>(out);
+}
+
+std::string AccountStore::getCheckpointFilename() const
+{
+    return filename + ".checkpoint";
+}
+
+std::string AccountStore::getTempFilename() const
+{
+    return filename + ".tmp";
+}
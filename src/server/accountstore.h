@@ -0,0 +1,123 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef ACCOUNTSTORE_H
+#define ACCOUNTSTORE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <SFML/Network.hpp>
+
+/*
+This class stores a record of binary data for each account ID, in a single file that is only ever appended to.
+Saving an account appends a new record, and the offset of the newest record for each ID is kept in memory.
+    So a save is one write at the end of the file, and a load is one seek and one read.
+Each record has a checksum, and only complete records with a matching checksum are used.
+    If the server stops in the middle of a save, the cut off record is thrown away the next time the file is opened,
+        and the account keeps its previous record.
+The old records are left in the file until it is compacted.
+    Compacting copies only the newest records into a new file, and then renames it over the old one.
+        (With the Synced durability, the new file is synced before it's renamed)
+    This is needed once the old records take up more space than the newest ones.
+    It can be done a few records at a time with continueCompaction, so reads and writes can still happen in between.
+        Any record that was written after its account was copied gets copied again right before the rename.
+    If compacting fails, it isn't tried again until the file grows some more.
+The offsets are also saved to a checkpoint file, so opening the store only reads that
+    and the records appended after it, instead of the whole file.
+    The checkpoint has the generation of the file it was made for, so it's ignored after a compaction it didn't see.
+
+File format (all numbers are little endian):
+    Header: "UMA" and a version byte, then the generation (Uint32)
+    Record: data size (Uint32), checksum (Uint32) of the account ID and data, account ID (Int32), then the data
+Checkpoint format:
+    Header: "UMC" and a version byte, then the generation (Uint32), and the size of the store it covers (Uint64)
+    The live bytes (Uint64), the number of IDs (Uint32), then for each ID: record offset (Uint64), record size (Uint32)
+    Checksum (Uint32) of everything before it
+*/
+class AccountStore
+{
+    public:
+        // How far a record gets pushed towards the disk when it's committed
+        enum Durability
+        {
+            Buffered, // Left in the file buffer, which is written when it fills up, at checkpoints, and on close
+            Flushed, // Handed to the operating system, so it survives the server crashing
+            Synced // Written to the disk, so it survives the whole machine crashing
+        };
+
+        AccountStore();
+        ~AccountStore();
+
+        AccountStore(const AccountStore&) = delete;
+        AccountStore& operator=(const AccountStore&) = delete;
+
+        bool open(const std::string& filename); // Creates the file if it doesn't exist
+        bool isOpen() const;
+        bool contains(int accountId) const;
+        bool read(int accountId, sf::Packet& data); // Returns false if there isn't a valid record for the ID
+        bool write(int accountId, const sf::Packet& data); // Appends and commits a record
+        bool append(int accountId, const sf::Packet& data); // Appends a record, so a batch can be committed at once
+        bool commit();
+        void setDurability(Durability newDurability);
+
+        bool needsCompaction() const; // Also true while a compaction is in progress
+        bool compact(); // Does the whole compaction (or the rest of it) at once, returns true if it succeeded
+        bool continueCompaction(unsigned maxRecords); // Copies some of the records, returns true once the compaction is over
+        void cancelCompaction();
+        bool writeCheckpoint();
+
+        unsigned getRecordCount() const; // Number of accounts with a record
+        sf::Uint64 getFileSize() const;
+        sf::Uint64 getLiveBytes() const; // Bytes used by the newest records
+
+    private:
+        struct Entry
+        {
+            sf::Uint64 offset; // 0 if there isn't a record for this ID
+            sf::Uint32 size; // Including the record header
+        };
+
+        static const char version = 1;
+        static const sf::Uint32 headerSize = 8;
+        static const sf::Uint32 recordHeaderSize = 12;
+        static const sf::Uint32 maxRecordSize = 16 * 1024 * 1024; // Anything bigger must be corrupted
+        static const sf::Uint64 minCompactionSize = 1024 * 1024; // Small files aren't worth compacting
+        static const unsigned checkpointInterval = 1000; // Records appended between checkpoints
+
+        bool startCompaction();
+        bool copyRecords(unsigned maxRecords); // Copies the next records into the compacted file
+        bool copyRecord(unsigned accountId);
+        bool finishCompaction();
+        void failCompaction();
+        bool create();
+        bool loadCheckpoint(sf::Uint64& coveredSize); // Returns false if the checkpoint is missing or out of date
+        void scan(sf::Uint64 offset); // Reads the records from the offset to the end, and drops a cut off record
+        bool readRecord(sf::Uint64 offset, sf::Int32& accountId, std::vector<char>& data);
+        void setEntry(int accountId, sf::Uint64 offset, sf::Uint32 size);
+        bool writeRecord(std::ostream& out, int accountId, const void* data, std::size_t size);
+        std::string getCheckpointFilename() const;
+        std::string getTempFilename() const;
+
+        std::string filename;
+        std::fstream file;
+        Durability durability;
+        sf::Uint32 generation;
+        sf::Uint64 fileSize;
+        sf::Uint64 liveBytes;
+        unsigned recordCount;
+        unsigned sinceCheckpoint;
+        std::vector<Entry> entries; // Indexed by account ID
+        std::vector<char> buffer; // Reused for reading and writing records
+
+        // The compaction in progress
+        bool compacting;
+        std::ofstream compactedFile;
+        unsigned compactionNextId; // The next account to copy
+        sf::Uint64 compactedSize;
+        std::vector<Entry> compactedEntries; // Where the copied records are in the compacted file
+        std::vector<sf::Uint64> copiedFrom; // Where the copied records were in this file, to find the ones written since
+        sf::Uint64 retryCompactionSize; // After a compaction fails, the file has to reach this size before another one
+};
+
+#endif
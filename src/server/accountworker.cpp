@@ -0,0 +1,161 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "accountworker.h"
+#include <utility>
+
+AccountWorker::AccountWorker(const std::string& directory, bool threaded, bool indexSnapshot,
+                             AccountStore::Durability durability):
+    db(directory, indexSnapshot),
+    threaded(threaded),
+    pendingCount(0),
+    stopping(false)
+{
+    db.setDurability(durability);
+    if (threaded)
+        thread = std::thread(&AccountWorker::workerLoop, this);
+}
+
+AccountWorker::~AccountWorker()
+{
+    if (threaded)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_one();
+        thread.join();
+    }
+}
+
+void AccountWorker::logIn(const std::string& username, const std::string& password, LogInCallback callback)
+{
+    Request request;
+    request.type = Request::LogIn;
+    request.playerData.username = username;
+    request.password = password;
+    request.logInCallback = std::move(callback);
+    queue(request);
+}
+
+void AccountWorker::createAccount(const PlayerData& playerData, StatusCallback callback)
+{
+    Request request;
+    request.type = Request::CreateAccount;
+    request.playerData = playerData;
+    request.statusCallback = std::move(callback);
+    queue(request);
+}
+
+void AccountWorker::saveAccount(const PlayerData& playerData, StatusCallback callback)
+{
+    Request request;
+    request.type = Request::Save;
+    request.playerData = playerData;
+    request.statusCallback = std::move(callback);
+    queue(request);
+}
+
+void AccountWorker::saveAccounts(std::vector<AccountDb::SavedAccount> accounts, StatusCallback callback)
+{
+    Request request;
+    request.type = Request::SaveBatch;
+    request.batch = std::move(accounts);
+    request.statusCallback = std::move(callback);
+    queue(request);
+}
+
+unsigned AccountWorker::deliverCompletions(unsigned maxCount)
+{
+    unsigned delivered = 0;
+    Request request;
+    while (delivered < maxCount && completions.tryPop(request))
+    {
+        if (request.type == Request::LogIn)
+        {
+            if (request.logInCallback)
+                request.logInCallback(request.status, request.playerData);
+        }
+        else if (request.statusCallback)
+            request.statusCallback(request.status);
+        --pendingCount;
+        ++delivered;
+    }
+    return delivered;
+}
+
+unsigned AccountWorker::getPendingCount() const
+{
+    return pendingCount;
+}
+
+void AccountWorker::queue(Request& request)
+{
+    ++pendingCount;
+    if (threaded)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requests.push_back(std::move(request));
+        }
+        condition.notify_one();
+    }
+    else
+    {
+        handle(request);
+        completions.push(std::move(request));
+        if (db.needsCompaction())
+            db.compact();
+    }
+}
+
+void AccountWorker::handle(Request& request)
+{
+    switch (request.type)
+    {
+        case Request::LogIn:
+        {
+            std::string username = request.playerData.username;
+            request.status = db.logIn(username, request.password, request.playerData);
+            break;
+        }
+        case Request::CreateAccount:
+            request.status = db.createAccount(request.playerData);
+            break;
+        case Request::Save:
+            request.status = db.saveAccount(request.playerData);
+            break;
+        case Request::SaveBatch:
+            request.status = db.saveAccounts(request.batch);
+            request.batch.clear();
+            break;
+    }
+}
+
+void AccountWorker::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        condition.wait(lock, [this]{ return stopping || !requests.empty() || db.needsCompaction(); });
+        if (requests.empty())
+        {
+            if (stopping)
+                break; // Only stop once everything has been saved
+            // Compacting is only done between requests, and in small parts so the next request doesn't wait long
+            lock.unlock();
+            db.continueCompaction();
+            lock.lock();
+            continue;
+        }
+        Request request = std::move(requests.front());
+        requests.pop_front();
+
+        // The files are read and written without holding the lock, so queueing more requests never waits on the disk
+        lock.unlock();
+        handle(request);
+        completions.push(std::move(request));
+        lock.lock();
+    }
+}
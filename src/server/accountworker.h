@@ -0,0 +1,101 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef ACCOUNTWORKER_H
+#define ACCOUNTWORKER_H
+
+#include <string>
+#include <climits>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "accountdb.h"
+#include "playerdata.h"
+#include "mpscqueue.h"
+
+/*
+This class does all of the account loading and saving on its own thread, so slow disks never stall the tick.
+The account database is only used by the worker thread, so it doesn't need any locks of its own.
+Requests are handled one at a time in the order they were made.
+    So a login after a logout always sees what the logout saved.
+When a request is done, its callback is queued, and only called from deliverCompletions.
+    The server calls that during the tick, so the callbacks can safely change the game state.
+Without a thread, each request is done right away, but its callback still waits for deliverCompletions.
+    Replays use this, and only deliver as many each tick as were delivered when the journal was recorded.
+While there aren't any requests, the account store is compacted a small part at a time.
+    So a request never waits for more than one part, instead of the whole file being rewritten.
+    Without a thread there isn't any idle time, so the whole compaction is done after the request that needed it.
+When this is destroyed, all of the requests are finished first, so no saves are lost.
+    A compaction that isn't done yet is dropped, and starts over the next time.
+
+Example usage:
+accounts.logIn(username, password, [](int status, PlayerData& playerData)
+{
+    // Called from deliverCompletions once the account is loaded
+});
+...
+accounts.deliverCompletions(); // Once per tick
+*/
+class AccountWorker
+{
+    public:
+        using LogInCallback = std::function<void(int, PlayerData&)>; // Login status, and the loaded player data
+        using StatusCallback = std::function<void(int)>;
+
+        AccountWorker(const std::string& directory, bool threaded = true, bool indexSnapshot = true,
+                      AccountStore::Durability durability = AccountStore::Flushed);
+        ~AccountWorker();
+
+        AccountWorker(const AccountWorker&) = delete;
+        AccountWorker& operator=(const AccountWorker&) = delete;
+
+        // These only queue the request, and return right away
+        void logIn(const std::string& username, const std::string& password, LogInCallback callback);
+        void createAccount(const PlayerData& playerData, StatusCallback callback); // Gets a create account status code
+        void saveAccount(const PlayerData& playerData, StatusCallback callback = nullptr); // Gets 1 if it was saved
+        void saveAccounts(std::vector<AccountDb::SavedAccount> accounts, StatusCallback callback = nullptr); // Gets how many were saved
+
+        unsigned deliverCompletions(unsigned maxCount = UINT_MAX); // Calls the callbacks of the finished requests, returns how many were called
+        unsigned getPendingCount() const; // Requests that haven't been delivered yet
+
+    private:
+        struct Request
+        {
+            enum Type
+            {
+                LogIn,
+                CreateAccount,
+                Save,
+                SaveBatch
+            };
+
+            Type type;
+            PlayerData playerData; // Also has the username to log in with
+            std::string password;
+            std::vector<AccountDb::SavedAccount> batch;
+            int status;
+            LogInCallback logInCallback;
+            StatusCallback statusCallback;
+        };
+
+        void queue(Request& request);
+        void handle(Request& request);
+        void workerLoop();
+
+        AccountDb db;
+        bool threaded;
+        unsigned pendingCount;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<Request> requests;
+        bool stopping;
+        std::thread thread;
+
+        MpscQueue<Request> completions;
+};
+
+#endif
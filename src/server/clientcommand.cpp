@@ -0,0 +1,98 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "clientcommand.h"
+#include <iostream>
+#include "packet.h"
+
+ClientCommand::ClientCommand():
+    ClientCommand(Invalid, -1)
+{
+}
+
+ClientCommand::ClientCommand(Type type, int clientId):
+    type(type),
+    clientId(clientId),
+    code(-1),
+    complete(false),
+    angle(0),
+    slot(-1),
+    otherSlot(-1),
+    primary(false),
+    sequence(0),
+    protocolVersion(-1)
+{
+}
+
+bool ClientCommand::decode(sf::Packet& packet, int id)
+{
+    *this = ClientCommand(Invalid, id);
+    int packetType = -1;
+    packet >> packetType;
+    switch (packetType)
+    {
+        case Packet::Input:
+            type = Input;
+            return decodeInput(packet);
+        case Packet::ChatMessage:
+            type = ChatMessage;
+            return decodeChatMessage(packet);
+        case Packet::SnapshotAck:
+            type = SnapshotAck;
+            return static_cast<bool>(packet >> sequence);
+        case Packet::LogIn:
+            // These are always valid, so that the client gets a status back
+            type = LogIn;
+            if (packet >> protocolVersion)
+                complete = static_cast<bool>(packet >> username >> password);
+            else
+                protocolVersion = -1;
+            return true;
+        case Packet::CreateAccount:
+            type = CreateAccount;
+            if (packet >> protocolVersion)
+                complete = static_cast<bool>(packet >> username >> password);
+            else
+                protocolVersion = -1;
+            return true;
+        default:
+            std::cout << "Error: Unknown received packet type. Type = " << packetType << std::endl;
+            return false;
+    }
+}
+
+bool ClientCommand::decodeInput(sf::Packet& packet)
+{
+    if (!(packet >> code))
+        return false;
+    switch (code)
+    {
+        case Packet::InputType::StartMoving:
+        case Packet::InputType::ChangeVisualAngle:
+            return static_cast<bool>(packet >> angle);
+        case Packet::InputType::StopMoving:
+        case Packet::InputType::PickupItem:
+            return true;
+        case Packet::InputType::UseItem:
+        case Packet::InputType::DropItem:
+            return static_cast<bool>(packet >> slot);
+        case Packet::InputType::SwapItem:
+            return static_cast<bool>(packet >> slot >> otherSlot);
+        case Packet::InputType::WieldItem:
+            return static_cast<bool>(packet >> slot >> primary);
+        default:
+            std::cout << code << " is an unknown or not yet implemented input type.\n";
+            return false;
+    }
+}
+
+bool ClientCommand::decodeChatMessage(sf::Packet& packet)
+{
+    if (!(packet >> code))
+        return false;
+    if (code == Packet::Chat::Private)
+        return static_cast<bool>(packet >> username >> message);
+    if (code == Packet::Chat::Public)
+        return static_cast<bool>(packet >> message);
+    return false;
+}
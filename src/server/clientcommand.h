@@ -0,0 +1,61 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef CLIENTCOMMAND_H
+#define CLIENTCOMMAND_H
+
+#include <string>
+#include <vector>
+#include <SFML/Network.hpp>
+
+/*
+This struct is a packet (or event) from a client that has already been decoded into its values.
+The packets are decoded on the network thread, and the commands are handled later by the main thread during a tick.
+    This way the network thread never touches the game state, so neither thread has to wait for the other.
+Only the members used by the type (and sub-type) of command are set, the rest keep their default values.
+*/
+struct ClientCommand
+{
+    enum Type
+    {
+        Invalid,
+        Disconnected,
+        Input, // The input type is in code
+        ChatMessage, // The chat type is in code
+        SnapshotAck,
+        LogIn,
+        CreateAccount
+    };
+
+    ClientCommand();
+    ClientCommand(Type type, int clientId);
+
+    bool decode(sf::Packet&, int); // Decodes a packet from a client ID, returns false if the packet was invalid
+
+    Type type;
+    int clientId; // The ID of the client from the TCP server
+    int code; // The sub-type, like Packet::InputType or Packet::Chat
+    bool complete; // For logging in and creating accounts, true if all of the values were in the packet
+
+    // Input
+    float angle;
+    int slot; // Inventory slot
+    int otherSlot; // Inventory slot to swap with
+    bool primary; // Which hand to wield with
+
+    sf::Uint32 sequence; // Snapshot sequence number
+
+    int protocolVersion; // -1 if it wasn't in the packet
+    sf::IpAddress address; // Of the client logging in
+    std::string username; // Also the receiver of private chat messages
+    std::string password;
+    std::string message;
+
+    std::vector<char> rawPacket; // The packet this came from, only kept while recording a packet journal
+
+    private:
+        bool decodeInput(sf::Packet&);
+        bool decodeChatMessage(sf::Packet&);
+};
+
+#endif
@@ -2,7 +2,158 @@
 // See the file LICENSE.txt for copying conditions.
 
 #include "entitygrid.h"
+#include <algorithm>
 
-EntityGrid::EntityGrid()
+EntityGrid::EntityGrid():
+    cellSize(defaultCellSize),
+    columns(0),
+    rows(0)
 {
 }
+
+EntityGrid::EntityGrid(int width, int height, int newCellSize)
+{
+    setSize(width, height, newCellSize);
+}
+
+void EntityGrid::setSize(int width, int height, int newCellSize)
+{
+    cellSize = std::max(newCellSize, 1);
+    // The positions can be equal to the width and height, so there needs to be room for those
+    columns = std::max(width, 0) / cellSize + 1;
+    rows = std::max(height, 0) / cellSize + 1;
+    cells.clear();
+    cells.resize(columns * rows);
+    entCells.clear();
+}
+
+void EntityGrid::clear()
+{
+    columns = 0;
+    rows = 0;
+    cells.clear();
+    entCells.clear();
+}
+
+void EntityGrid::removeAll()
+{
+    for (auto& cell: cells)
+        cell.clear();
+    entCells.clear();
+}
+
+void EntityGrid::insert(int index, const sf::Vector2f& pos)
+{
+    if (index < 0 || cells.empty())
+        return;
+    if (index >= (int)entCells.size())
+        entCells.resize(index + 1, -1);
+    else if (entCells[index] >= 0)
+        removeFromCell(index, entCells[index]); // Don't let an entity be in 2 cells at once
+    int cellIndex = getCellIndex(pos);
+    cells[cellIndex].push_back(index);
+    entCells[index] = cellIndex;
+}
+
+void EntityGrid::erase(int index)
+{
+    if (contains(index))
+    {
+        removeFromCell(index, entCells[index]);
+        entCells[index] = -1;
+    }
+}
+
+bool EntityGrid::update(int index, const sf::Vector2f& pos)
+{
+    if (!contains(index))
+        return false;
+    int oldCell = entCells[index];
+    int newCell = getCellIndex(pos);
+    if (oldCell == newCell)
+        return false;
+    removeFromCell(index, oldCell);
+    cells[newCell].push_back(index);
+    entCells[index] = newCell;
+    return true;
+}
+
+bool EntityGrid::changesCell(int index, const sf::Vector2f& pos) const
+{
+    return (contains(index) && entCells[index] != getCellIndex(pos));
+}
+
+void EntityGrid::getEntities(const sf::FloatRect& area, std::vector<int>& results) const
+{
+    if (!cells.empty())
+        appendCells(getCellX(area.left), getCellY(area.top), getCellX(area.left + area.width), getCellY(area.top + area.height), results);
+}
+
+void EntityGrid::getEntities(const sf::Vector2f& center, float radius, std::vector<int>& results) const
+{
+    getEntities(sf::FloatRect(center.x - radius, center.y - radius, radius * 2, radius * 2), results);
+}
+
+void EntityGrid::getNeighbours(const sf::Vector2f& pos, std::vector<int>& results) const
+{
+    if (!cells.empty())
+    {
+        int x = getCellX(pos.x);
+        int y = getCellY(pos.y);
+        appendCells(x - 1, y - 1, x + 1, y + 1, results);
+    }
+}
+
+int EntityGrid::getCellSize() const
+{
+    return cellSize;
+}
+
+bool EntityGrid::contains(int index) const
+{
+    return (index >= 0 && index < (int)entCells.size() && entCells[index] >= 0);
+}
+
+int EntityGrid::getCellX(float x) const
+{
+    return std::min(std::max(static_cast<int>(x) / cellSize, 0), columns - 1);
+}
+
+int EntityGrid::getCellY(float y) const
+{
+    return std::min(std::max(static_cast<int>(y) / cellSize, 0), rows - 1);
+}
+
+int EntityGrid::getCellIndex(const sf::Vector2f& pos) const
+{
+    return getCellY(pos.y) * columns + getCellX(pos.x);
+}
+
+void EntityGrid::appendCells(int x1, int y1, int x2, int y2, std::vector<int>& results) const
+{
+    // Keep the range inside of the grid
+    x1 = std::max(x1, 0);
+    y1 = std::max(y1, 0);
+    x2 = std::min(x2, columns - 1);
+    y2 = std::min(y2, rows - 1);
+    for (int y = y1; y <= y2; ++y)
+    {
+        for (int x = x1; x <= x2; ++x)
+        {
+            const MicroList& cell = cells[y * columns + x];
+            results.insert(results.end(), cell.begin(), cell.end());
+        }
+    }
+}
+
+void EntityGrid::removeFromCell(int index, int cellIndex)
+{
+    // The order of the indexes in a cell doesn't matter, so just swap with the last one
+    MicroList& cell = cells[cellIndex];
+    auto found = std::find(cell.begin(), cell.end(), index);
+    if (found != cell.end())
+    {
+        *found = cell.back();
+        cell.pop_back();
+    }
+}
@@ -4,37 +4,67 @@
 /*
 ENTITY GRID (server only)
 EntityGrid class:
-    Will contain a 2D array of sets of entity IDs.
+    A uniform spatial hash: the map is split into square cells, and each cell stores the indexes of the entities in it.
+        (The index part of an entity ID, see entityid.h. This keeps the arrays in here as small as the entity list.)
+    The cells are stored in a single flat array (row by row), so there are no per-row allocations.
+    The grid also remembers which cell every entity is in, so it can tell when an entity crosses into a new cell.
     This will only be used on the server.
 Purpose:
     To spatially partition the entities to dramatically improve performance when doing anything with entities.
     Also improves performance and simplicity of deciding what entities to send to the clients.
-        A 3x3 portion (or something like that) of the entity grid will be sent to each client.
+        Only the cells around each client need to be looked at.
 Caveats:
-    Entity movement code will be slightly more complex.
-        When an entity is out of bounds, it will need to be moved to the proper grid location.
+    The grid does not know where the entities are, only which cell they are in.
+        The queries return every entity in the cells that overlap the area, so the caller should do any exact checks.
+    Entities must be updated with their new position after they move, or they will be in the wrong cell.
+        Positions outside of the grid are clamped to the nearest edge cell.
 */
 
 #ifndef ENTITYGRID_H
 #define ENTITYGRID_H
 
 #include <vector>
-#include <set>
+#include <SFML/Graphics/Rect.hpp>
 #include "entity.h"
 
 class EntityGrid
 {
     public:
-        using MicroList = std::set<EID>;
+        using MicroList = std::vector<int>;
+
+        static const int defaultCellSize = 256;
 
         EntityGrid(); // Starts out as 0x0, must call setSize after this
-        EntityGrid(int, int);
+        EntityGrid(int, int, int = defaultCellSize); // Width and height in pixels, cell size in pixels
 
-        void setSize(int, int); // Sets the size of the grid, same as constructor
+        void setSize(int, int, int = defaultCellSize); // Sets the size of the grid, same as constructor (also removes all entities)
         void clear(); // Removes everything and resizes the grid back to 0x0
+        void removeAll(); // Removes all of the entities, but keeps the size of the grid
+
+        void insert(int, const sf::Vector2f&); // Adds an entity to the cell at a position
+        void erase(int); // Removes an entity from the cell it is in
+        bool update(int, const sf::Vector2f&); // Moves an entity to another cell if needed, returns true if it changed cells
+        bool changesCell(int, const sf::Vector2f&) const; // Returns true if update would move the entity to another cell
+
+        // These append the entity indexes of every cell that overlaps the area into the vector
+        void getEntities(const sf::FloatRect&, std::vector<int>&) const; // Rectangle in pixels
+        void getEntities(const sf::Vector2f&, float, std::vector<int>&) const; // Center and radius in pixels
+        void getNeighbours(const sf::Vector2f&, std::vector<int>&) const; // The 3x3 block of cells around a position
+
+        int getCellSize() const;
+        bool contains(int) const; // Returns true if the entity is in the grid
 
     private:
-        std::vector< std::vector<MicroList> > grid;
+        int getCellX(float) const;
+        int getCellY(float) const;
+        int getCellIndex(const sf::Vector2f&) const;
+        void appendCells(int, int, int, int, std::vector<int>&) const; // Appends the cells from (x1, y1) to (x2, y2)
+        void removeFromCell(int, int);
+
+        int cellSize; // The width and height of a cell in pixels
+        int columns, rows; // The size of the grid in cells
+        std::vector<MicroList> cells; // All of the cells, accessed by (y * columns + x)
+        std::vector<int> entCells; // The cell index of each entity, accessed by entity index (-1 if it isn't in the grid)
 };
 
 #endif
@@ -55,6 +55,26 @@ void Inventory::saveToConfig(cfg::File& config) const
     config.useSection();
 }
 
+void Inventory::loadFromPacket(sf::Packet& packet)
+{
+    sf::Uint32 left = 0, right = 0, count = 0;
+    packet >> left >> right >> count;
+    leftSlotId = left;
+    rightSlotId = right;
+    itemSlots.clear();
+    ItemCode item;
+    for (sf::Uint32 i = 0; i < count && packet >> item; ++i)
+        itemSlots.push_back(item);
+}
+
+void Inventory::saveToPacket(sf::Packet& packet) const
+{
+    packet << static_cast<sf::Uint32>(leftSlotId) << static_cast<sf::Uint32>(rightSlotId);
+    packet << static_cast<sf::Uint32>(itemSlots.size());
+    for (auto& item: itemSlots)
+        packet << item;
+}
+
 bool Inventory::addItem(const ItemCode& item)
 {
     for (unsigned slotId = 0; slotId < itemSlots.size(); ++slotId)
@@ -22,6 +22,8 @@ class Inventory
         unsigned getSize() const;
         void loadFromConfig(cfg::File& config);
         void saveToConfig(cfg::File& config) const;
+        void loadFromPacket(sf::Packet& packet); // For the account store
+        void saveToPacket(sf::Packet& packet) const;
 
         // Item functions (none of these change the size of the inventory)
         bool addItem(const ItemCode& item); // Adds a new item into the first empty slot
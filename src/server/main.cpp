@@ -1,10 +1,21 @@
 // See the file COPYRIGHT.txt for authors and copyright information.
 // See the file LICENSE.txt for copying conditions.
 
+#include <string>
 #include "server.h"
 
-int main()
+int main(int argc, char* argv[])
 {
-    Server zombieServer;
-    zombieServer.start();
+    // Run with --benchmark to time the game loop without any clients (see the benchmark options in server.cfg)
+    // Run with --replay and a file to replay a packet journal recorded with the journalFile option
+    std::string option = (argc > 1 ? argv[1] : "");
+    if (option == "--benchmark")
+        Server(Server::Benchmark).start();
+    else if (option == "--replay" && argc > 2)
+        Server(Server::Replay, argv[2]).start();
+    else
+    {
+        Server zombieServer;
+        zombieServer.start();
+    }
 }
@@ -3,180 +3,419 @@
 
 #include "masterentitylist.h"
 #include <iostream>
-#include "entityalloc.h"
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <cmath>
 #include "packet.h"
+#include "packetcodec.h"
 
-unsigned int MasterEntityList::entCount = 0;
 const int MasterEntityList::cleanUpRatio = 4;
+const int MasterEntityList::updateGrainSize = 4096;
+const float MasterEntityList::collisionRadius = 32;
 
-MasterEntityList::MasterEntityList()
+MasterEntityList::MasterEntityList():
+    entCount(0),
+    currentTick(0)
 {
 }
 
+MasterEntityList::~MasterEntityList()
+{
+    for (auto& ent: ents)
+        allocator.free(ent);
+    allocator.releasePending();
+}
+
+void MasterEntityList::setMapSize(int width, int height, int cellSize)
+{
+    grid.setSize(width, height, cellSize);
+    rebuildGrid(); // Put back any entities that were already added
+    movement.setBounds(width, height);
+}
+
 Entity* MasterEntityList::add(int type)
 {
-    return insert(allocateEntity(type));
+    return insert(allocator.allocate(type));
 }
 
 Entity* MasterEntityList::insert(Entity* newEnt)
 {
     if (newEnt != nullptr) // Don't add a null pointer to the list!
     {
-        entCount++;
-        EID id = 0;
-        if (freeList.empty()) // If the free list is empty
+        int index = 0;
+        if (freeIndexes.empty()) // If the free list is empty
         {
             // Simply append this entity to the end of the master list
-            id = entCount - 1;
+            index = ents.size();
+            if (index > EntityId::maxIndex)
+            {
+                std::cerr << "ERROR: Ran out of entity IDs!\n";
+                allocator.free(newEnt);
+                return nullptr;
+            }
             ents.push_back(newEnt);
+            changeTicks.emplace_back();
+            if (index >= (int)generations.size())
+                generations.push_back(0);
         }
         else // If the free list is not empty
         {
-            // Use the oldest ID from the free list
-            id = freeList.front();
-            freeList.pop_front();
-            ents[id] = newEnt;
+            // Use the lowest free index, so the entities stay packed at the front of the list
+            std::pop_heap(freeIndexes.begin(), freeIndexes.end(), std::greater<int>());
+            index = freeIndexes.back();
+            freeIndexes.pop_back();
+            ents[index] = newEnt;
         }
-        newEnt->setID(id);
+        entCount++;
+        newEnt->setID(EntityId::make(index, generations[index]));
+        newEnt->attachMovement(&movement);
+        newEnt->attachDirtyList(&dirtyEnts);
+        grid.insert(index, newEnt->getPos());
+        resetChangeTicks(index);
     }
     return newEnt;
 }
 
 Entity* MasterEntityList::find(EID id) const
 {
-    if (idIsInRange(id))
-        return ents[id];
+    // Old IDs will have a different generation than the entity that is using the index now
+    int index = EntityId::getIndex(id);
+    if (indexIsInRange(index) && ents[index] != nullptr && ents[index]->getID() == id)
+        return ents[index];
     else
         return nullptr;
 }
 
 void MasterEntityList::erase(EID id)
 {
-    if (idIsInRange(id) && ents[id] != nullptr)
+    if (find(id) != nullptr)
     {
+        int index = EntityId::getIndex(id);
         entCount--;
-        delete ents[id]; // Deallocate
-        ents[id] = nullptr; // Set pointer to null
-        freeList.push_back(id); // Add the ID to the free list
-        deletedEnts.push_back(id); // Add the ID to the deleted entity list
+        grid.erase(index); // Remove it from the grid
+        movement.remove(index);
+        ents[index]->attachDirtyList(nullptr); // Its changes don't matter anymore
+        allocator.release(ents[index]); // Deallocate at the end of the tick, in case anything still points to it
+        ents[index] = nullptr; // Set pointer to null
+        ++generations[index]; // Make the old ID invalid
+        freeIndexes.push_back(index); // Add the index to the free list
+        std::push_heap(freeIndexes.begin(), freeIndexes.end(), std::greater<int>());
     }
 }
 
+void MasterEntityList::releaseErased()
+{
+    allocator.releasePending();
+}
+
+const EntityAllocator& MasterEntityList::getAllocator() const
+{
+    return allocator;
+}
+
 /*
-This function cleans up any excess memory allocation by rebuilding the main list with only existing entities.
-It should only be called every once in a while. A long timed interval would be best.
-Returns true if the clean up process ran, otherwise returns false.
-TODO: Maybe instead it could return the number of seconds it took as a float?
-TODO: An alternative "lighter" method would be to try using smaller IDs for new entities, and simply shrink
-    the main entity vector to the largest existing entity ID. This would free some memory without doing
-    any damaging effects like re-assigning all of the IDs, which may cause many problems in the future.
+This function frees any excess memory by shrinking the list down to the last existing entity.
+The IDs don't change, so it can be called at any time. It only does anything if the list is mostly empty.
+Since the lowest free indexes are always used first, the entities tend to be packed at the front of the list.
+Returns true if the list was shrunk, otherwise returns false.
 */
 bool MasterEntityList::cleanUp()
 {
     // If the cleanUpRatio is 4, that means that this clean up function will only run if:
     // the entity list size is greater than the actual number of entities times 4.
     // So for a list with 10 entities, it won't run until that list is greater than 40 elements.
-    if (ents.size() > entCount * cleanUpRatio)
+    if (ents.size() <= entCount * cleanUpRatio)
+        return false;
+    unsigned newSize = ents.size();
+    while (newSize > 0 && ents[newSize - 1] == nullptr)
+        --newSize;
+    if (newSize == ents.size())
+        return false;
+    ents.resize(newSize);
+    ents.shrink_to_fit();
+    changeTicks.resize(newSize);
+    changeTicks.shrink_to_fit();
+    movement.resize(newSize);
+    // The generations are kept, so that if the list grows again, the old IDs still won't be reused
+    // Remove the indexes that don't exist anymore from the free list
+    freeIndexes.erase(std::remove_if(freeIndexes.begin(), freeIndexes.end(), [newSize](int index) { return index >= (int)newSize; }),
+        freeIndexes.end());
+    std::make_heap(freeIndexes.begin(), freeIndexes.end(), std::greater<int>());
+    return true;
+}
+
+void MasterEntityList::update(float time, JobSystem* jobs)
+{
+    // Move everything at once, then copy the new positions back into the entities that moved
+    // Moving is all that the entities do in their update functions, so those don't need to be called
+    int count = movement.size();
+    if (jobs == nullptr || jobs->getThreadCount() <= 1)
     {
-        // Clear the free list, as there will not be any free IDs afterwards!
-        freeList.clear();
-        // Go through and build a new temporary vector with existing entities
-        // Also assign them with new IDs!!!
-        std::vector <Entity*> entsTmp;
-        for (EID id = 0; id < (int)ents.size(); id++)
+        movement.integrate(time);
+        for (int index = 0; index < count; ++index)
         {
-            if (ents[id] != nullptr)
+            if (movement.isMoving(index))
             {
-                ents[id]->setID(entsTmp.size());
-                ents[id]->setChanged(true);
-                deletedEnts.push_back(id);
-                entsTmp.push_back(ents[id]);
+                sf::Vector2f pos = movement.getPos(index);
+                ents[index]->applyMovement(pos, movement.getEdgeHits(index));
+                grid.update(index, pos); // Move it into its new cell if it crossed into one
             }
         }
-        // Clear the old vector
-        ents.clear();
-        // Move the temp vector back into the original vector
-        ents.swap(entsTmp); // This may be faster than using the assignment operator=
-        // Done cleaning up!
-        // TODO: Now all of the IDs are invalid and need to be updated on the client side...
-        return true;
+        return;
+    }
+
+    // Each range of entities is moved by a separate job, but the grid and dirty list can only be changed by one thread
+    // Entities that hit an edge (which changes their angle) or crossed into another cell are finished afterwards
+    std::vector<std::vector<int>> deferred((count + updateGrainSize - 1) / updateGrainSize);
+    jobs->parallelFor(count, updateGrainSize, [&](int begin, int end)
+    {
+        movement.integrate(time, begin, end);
+        std::vector<int>& rangeDeferred = deferred[begin / updateGrainSize];
+        for (int index = begin; index < end; ++index)
+        {
+            if (movement.isMoving(index))
+            {
+                sf::Vector2f pos = movement.getPos(index);
+                if (movement.getEdgeHits(index) == 0)
+                    ents[index]->applyMovement(pos, 0);
+                if (movement.getEdgeHits(index) != 0 || grid.changesCell(index, pos))
+                    rangeDeferred.push_back(index);
+            }
+        }
+    });
+    for (const auto& rangeDeferred: deferred)
+    {
+        for (int index: rangeDeferred)
+        {
+            sf::Vector2f pos = movement.getPos(index);
+            if (movement.getEdgeHits(index) != 0)
+                ents[index]->applyMovement(pos, movement.getEdgeHits(index));
+            grid.update(index, pos);
+        }
     }
-    else
-        return false;
 }
 
-void MasterEntityList::update(float time)
+void MasterEntityList::updateGrid(Entity* ent)
 {
-    for (auto& ent: ents)
+    if (ent != nullptr)
+        grid.update(EntityId::getIndex(ent->getID()), ent->getPos());
+}
+
+Entity* MasterEntityList::findCollision(Entity* ent, EType type)
+{
+    Entity* closest = nullptr;
+    if (ent != nullptr)
+    {
+        // Only the entities in the cells around this entity could possibly be touching it
+        std::vector<int> nearby;
+        grid.getNeighbours(ent->getPos(), nearby);
+        const sf::Vector2f& pos = ent->getPos();
+        float closestDistSq = std::numeric_limits<float>::max();
+        for (int index: nearby)
+        {
+            Entity* other = ents[index];
+            if (other != nullptr && other != ent && (type == Entity::Invalid || other->getType() == type))
+            {
+                float dx = other->getPos().x - pos.x;
+                float dy = other->getPos().y - pos.y;
+                float distSq = dx * dx + dy * dy;
+                if (distSq <= collisionRadius * collisionRadius && distSq < closestDistSq)
+                {
+                    closest = other;
+                    closestDistSq = distSq;
+                }
+            }
+        }
+    }
+    return closest;
+}
+
+void MasterEntityList::findInRange(const sf::Vector2f& center, float radius, std::vector<Entity*>& results) const
+{
+    std::vector<int> nearby;
+    grid.getEntities(center, radius, nearby);
+    for (int index: nearby)
     {
+        Entity* ent = ents[index];
         if (ent != nullptr)
-            ent->update(time);
+        {
+            float dx = ent->getPos().x - center.x;
+            float dy = ent->getPos().y - center.y;
+            if (dx * dx + dy * dy <= radius * radius)
+                results.push_back(ent);
+        }
     }
 }
 
-Entity* MasterEntityList::findCollision(Entity* ent)
+const EntityGrid& MasterEntityList::getGrid() const
 {
-    // TODO: Write this function
-    return nullptr;
+    return grid;
 }
 
-bool MasterEntityList::getAllEntities(sf::Packet& packet)
+sf::Uint32 MasterEntityList::commitChanges()
 {
-    if (entCount > 0)
+    ++currentTick;
+    // Only the entities that changed are in the dirty list, so this doesn't need to look at every entity
+    while (Entity* ent = dirtyEnts.pop())
     {
-        std::cout << "getAllEntities()\n";
-        packet << Packet::EntityUpdate;
-        for (auto& ent: ents)
+        if (ent->hasChanged())
         {
-            if (ent != nullptr)
-                ent->getData(packet);
+            ChangeTicks& ticks = changeTicks[EntityId::getIndex(ent->getID())];
+            sf::Uint8 fields = ent->getChangedFields();
+            for (int i = 0; i < Entity::fieldCount; ++i)
+            {
+                if (fields & (1 << i))
+                    ticks.fields[i] = currentTick;
+            }
+            ent->setChanged(false);
         }
-        return true;
     }
-    else
-        return false;
+    return currentTick;
 }
 
-bool MasterEntityList::getChangedEntities(sf::Packet& packet)
+bool MasterEntityList::getChangedEntities(sf::Packet& packet, const sf::Vector2f& center, float radius, const SnapshotHistory& history,
+    PriorityAccumulator& priorities, unsigned maxBytes, Snapshot& snapshot) const
 {
+    // Get everything that is in range now, sorted by ID so it can be compared with the snapshots
+    std::vector<Entity*> inRange;
+    findInRange(center, radius, inRange);
+    std::sort(inRange.begin(), inRange.end(), [](const Entity* a, const Entity* b) { return a->getID() < b->getID(); });
+
+    static const std::vector<SnapshotEntity> noEnts;
+    const Snapshot* baseline = history.getBaseline();
+    const Snapshot* previous = history.getLatest();
+    const std::vector<SnapshotEntity>& baseEnts = (baseline != nullptr ? baseline->ents : noEnts);
+    const std::vector<SnapshotEntity>& prevEnts = (previous != nullptr ? previous->ents : noEnts);
+
+    // The entities that have something to send, which may not all fit
+    struct Candidate
+    {
+        Entity* ent;
+        sf::Uint8 header;
+        float priority;
+        unsigned snapshotIndex;
+    };
+    std::vector<Candidate> candidates;
+
     bool anyChanged = false;
-    packet << Packet::EntityUpdate;
-    // Get deleted entities
-    if (!deletedEnts.empty())
+    snapshot.ents.clear();
+    snapshot.ents.reserve(inRange.size());
+
+    auto baseEnt = baseEnts.begin();
+    auto prevEnt = prevEnts.begin();
+    for (Entity* ent: inRange)
     {
-        std::cout << "Deleted entity IDs: ";
-        for (auto& entId: deletedEnts)
+        EID id = ent->getID();
+        int index = EntityId::getIndex(id);
+        // Tell the client about entities that were deleted or went out of range since the previous update
+        // These are always sent, so the client doesn't keep entities that aren't there anymore
+        for (; prevEnt != prevEnts.end() && prevEnt->id < id; ++prevEnt)
         {
-            std::cout << entId << " ";
-            packet << entId << -1;
+            writeRemoved(packet, prevEnt->id, prevEnt->tick);
+            priorities.reset(EntityId::getIndex(prevEnt->id));
             anyChanged = true;
         }
-        std::cout << std::endl;
-        deletedEnts.clear();
-    }
-    // Get changed entities
-    if (entCount > 0)
-    {
-        for (auto& ent: ents)
+        // If this entity gets skipped, the client will still have what it had before this update
+        sf::Uint32 knownTick = 0;
+        bool inPrevious = (prevEnt != prevEnts.end() && prevEnt->id == id);
+        if (inPrevious)
+            knownTick = (prevEnt++)->tick;
+        while (baseEnt != baseEnts.end() && baseEnt->id < id)
+            ++baseEnt;
+        bool inBaseline = (baseEnt != baseEnts.end() && baseEnt->id == id);
+
+        // Only send the fields that changed since the baseline, if the client has had this entity since then
+        // If the client doesn't have it, or the ID was recycled for a new entity, then send everything
+        sf::Uint8 header = Entity::AllFields | Packet::EntityCode::Created;
+        if (inBaseline && inPrevious && changeTicks[index].created <= baseEnt->tick)
+            header = getFieldsChangedSince(index, baseEnt->tick);
+        if (header != 0)
         {
-            if (ent != nullptr && ent->hasChanged())
-            {
-                ent->getData(packet);
-                ent->setChanged(false);
-                anyChanged = true;
-            }
-            if (packet.getDataSize() >= sf::UdpSocket::MaxDatagramSize - 256)
-                break;
+            float distance = std::hypot(ent->getPos().x - center.x, ent->getPos().y - center.y);
+            candidates.push_back(Candidate{ent, header, priorities.accumulate(index, distance, radius), (unsigned)snapshot.ents.size()});
+            snapshot.ents.emplace_back(inPrevious ? id : -1, knownTick);
+        }
+        else
+        {
+            priorities.reset(index);
+            snapshot.ents.emplace_back(id, currentTick);
         }
-        /*if (anyChanged)
-            cout << "getChangedEntities()\n";*/
-        return anyChanged;
     }
-    else
-        return false;
+    for (; prevEnt != prevEnts.end(); ++prevEnt)
+    {
+        writeRemoved(packet, prevEnt->id, prevEnt->tick);
+        priorities.reset(EntityId::getIndex(prevEnt->id));
+        anyChanged = true;
+    }
+
+    // Send the most important entities first, until the packet is full
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.priority > b.priority; });
+    for (auto& candidate: candidates)
+    {
+        if (packet.getDataSize() >= maxBytes)
+            break;
+        EID id = candidate.ent->getID();
+        PacketCodec::writeVarInt(packet, id);
+        packet << candidate.header;
+        if (candidate.header & Packet::EntityCode::Created)
+            packet << static_cast<sf::Uint8>(candidate.ent->getType());
+        candidate.ent->getData(packet, candidate.header & Entity::AllFields);
+        priorities.reset(EntityId::getIndex(id));
+        snapshot.ents[candidate.snapshotIndex] = SnapshotEntity(id, currentTick);
+        anyChanged = true;
+    }
+
+    // Skipped entities that the client doesn't have yet aren't part of the snapshot
+    snapshot.ents.erase(std::remove_if(snapshot.ents.begin(), snapshot.ents.end(), [](const SnapshotEntity& snapEnt) { return snapEnt.id < 0; }),
+        snapshot.ents.end());
+
+    return anyChanged;
+}
+
+bool MasterEntityList::indexIsInRange(int index) const
+{
+    return (index >= 0 && index < (int)ents.size());
+}
+
+void MasterEntityList::resetChangeTicks(int index)
+{
+    // The entity will be committed on the next tick
+    ChangeTicks& ticks = changeTicks[index];
+    ticks.created = currentTick + 1;
+    for (auto& fieldTick: ticks.fields)
+        fieldTick = currentTick + 1;
 }
 
-bool MasterEntityList::idIsInRange(EID id) const
+sf::Uint8 MasterEntityList::getFieldsChangedSince(int index, sf::Uint32 tick) const
 {
-    return (id >= 0 && id < (int)ents.size());
+    sf::Uint8 fields = 0;
+    const ChangeTicks& ticks = changeTicks[index];
+    for (int i = 0; i < Entity::fieldCount; ++i)
+    {
+        if (ticks.fields[i] > tick)
+            fields |= (1 << i);
+    }
+    return fields;
+}
+
+void MasterEntityList::writeRemoved(sf::Packet& packet, EID id, sf::Uint32 knownTick) const
+{
+    // If the ID doesn't find anything now, then the entity was deleted
+    // (The created tick is checked too, in case the generation wrapped around to the same ID)
+    Entity* ent = find(id);
+    bool deleted = (ent == nullptr || changeTicks[EntityId::getIndex(id)].created > knownTick);
+    PacketCodec::writeVarInt(packet, id);
+    packet << static_cast<sf::Uint8>(Packet::EntityCode::Removed);
+    packet << static_cast<sf::Uint8>(deleted ? Packet::EntityCode::Deleted : Packet::EntityCode::OutOfRange);
+}
+
+void MasterEntityList::rebuildGrid()
+{
+    grid.removeAll();
+    for (auto& ent: ents)
+    {
+        if (ent != nullptr)
+            grid.insert(EntityId::getIndex(ent->getID()), ent->getPos());
+    }
 }
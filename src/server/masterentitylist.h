@@ -5,20 +5,23 @@
 MASTER ENTITY LIST (server only)
 MasterEntityList class:
     Use an std::vector<Entity*> for the main entity list, which stores ALL entities.
-        In addition to this, it should also store the entity's grid location, if we ever need to do that.
-    Use an std::list to store free IDs. (Only need efficient front/back/pop_front/push_back)
+        In addition to this, all of the entities are stored in an EntityGrid, which keeps track of their grid locations.
+        The movement state of the entities is also kept in MovementArrays, so they can all be moved at once.
+    Use a min-heap in an std::vector to store free indexes. (Always gives out the lowest free index)
 Purpose:
-    To manage the IDs of all of the entities. (Efficiently assigns new IDs by recycling them)
+    To manage the IDs of all of the entities. (Efficiently assigns new IDs by recycling their indexes)
     Also allows for instant access to entity pointers from entity IDs.
 Caveats:
-    This list must only be used for all entities. This is because the entire range of IDs must have allocated space.
-When a new entity is added, it will first try to get an ID from the front of the list/deque.
-    If this list is empty, it will generate a new one, 1 larger than the largest ID.
-    The IDs must be pulled from the front, so IDs are rotated. Otherwise the main list will basically leak memory.
+    This list must only be used for all entities. This is because the entire range of indexes must have allocated space.
+The IDs are generational handles (see entityid.h): the index of the entity in the list, plus a generation number.
+    Every time an index is reused, the generation goes up, so old IDs held by anything else won't find the new entity.
+    Everything else on the server that is accessed by ID (the grid, movement arrays, etc.) uses just the index.
+When a new entity is added, it will first try to get the lowest index from the free list.
+    If this list is empty, it will generate a new one, 1 larger than the largest index.
+    Using the lowest indexes first keeps the entities packed at the front, so cleanUp can shrink the list.
+The entities are allocated from pools in an EntityAllocator, and erased ones are freed all at once by releaseErased.
 When an entity is deleted, it will simply set the element to a null pointer.
-    The ID will be pushed onto the back of the free ID list/deque.
-This system is the most efficient so far, although it could possibly accumalate a lot of memory.
-    We could have a cleaning function that rebuilds the whole list and all of the entity IDs.
+    The index will be pushed onto the free list.
 Inserting and deleting entities is mostly just a single assignment operation.
 This would be a lot more thread safe than using another container, as memory isn't ever moved around or reallocated.
 */
@@ -28,32 +31,74 @@ This would be a lot more thread safe than using another container, as memory isn
 
 #include "entity.h"
 #include <vector>
-#include <list>
+#include "entityalloc.h"
+#include "entitygrid.h"
+#include "movementarrays.h"
+#include "dirtylist.h"
+#include "snapshothistory.h"
+#include "priorityaccumulator.h"
+#include "jobsystem.h"
 
 class MasterEntityList
 {
     public:
         MasterEntityList();
+        ~MasterEntityList();
+        void setMapSize(int, int, int = EntityGrid::defaultCellSize); // Map width/height and grid cell size in pixels
         Entity* add(int);
-        Entity* insert(Entity*);
-        Entity* find(EID) const;
+        Entity* insert(Entity*); // The entity must have been allocated by this list
+        Entity* find(EID) const; // Returns null if the entity doesn't exist anymore
         void erase(EID);
-        bool cleanUp();
-        void update(float);
-        Entity* findCollision(Entity*);
+        void releaseErased(); // Frees the memory of the erased entities, call this once nothing points to them anymore
+        const EntityAllocator& getAllocator() const;
+        bool cleanUp(); // Frees memory at the end of the list, the IDs don't change
+        void update(float, JobSystem* = nullptr); // Splits the work into jobs if a job system is passed in
+        void updateGrid(Entity*); // Call this after moving an entity outside of update()
+        Entity* findCollision(Entity*, EType = Entity::Invalid); // Returns the closest entity touching this one (of a type if specified)
+        void findInRange(const sf::Vector2f&, float, std::vector<Entity*>&) const; // Appends all entities within a radius of a position
+        const EntityGrid& getGrid() const;
 
-        // These only return true if they modified the packet
-        bool getAllEntities(sf::Packet&);
-        bool getChangedEntities(sf::Packet&);
+        // Stores the tick number of every changed field, and clears the changed fields. Returns the new tick number.
+        // This only goes through the entities that changed, which add themselves to a dirty list.
+        // Call this once per tick, before getting the changed entities for the clients.
+        sf::Uint32 commitChanges();
+
+        // Writes updates for the entities within a radius of a position, for a single client.
+        // The fields are compared to the baseline (the last snapshot the client acknowledged),
+        // and the entities are compared to the latest snapshot (what the client will have before this update).
+        // If there is no baseline, everything in range is sent in full.
+        // Removed entities are always written, then the changed entities are written in order of priority until
+        //     the packet reaches the maximum size. Skipped entities will gain priority for the next update.
+        // The new snapshot gets what the client will have after this. Returns true if anything was written to the packet.
+        bool getChangedEntities(sf::Packet&, const sf::Vector2f&, float, const SnapshotHistory&, PriorityAccumulator&, unsigned, Snapshot&) const;
 
     private:
-        bool idIsInRange(EID) const;
+        // The ticks that things changed on for a single entity, so changes can be found from any baseline
+        struct ChangeTicks
+        {
+            sf::Uint32 created; // The tick the entity was added on
+            sf::Uint32 fields[Entity::fieldCount]; // The tick each field last changed on
+        };
+
+        bool indexIsInRange(int) const;
+        void resetChangeTicks(int); // Marks an entity as newly added
+        sf::Uint8 getFieldsChangedSince(int, sf::Uint32) const;
+        void writeRemoved(sf::Packet&, EID, sf::Uint32) const; // Tells the client to remove an entity
+        void rebuildGrid();
 
-        static unsigned int entCount;
         static const int cleanUpRatio;
-        std::vector <Entity*> ents; // all of the entity pointers are stored here, and accessed by ID directly
-        std::list <EID> freeList; // unused IDs go here
-        std::vector <EID> deletedEnts; // used for sending which entities have been deleted to the clients
+        static const int updateGrainSize; // Entities per job in update
+        static const float collisionRadius;
+        unsigned int entCount;
+        std::vector <Entity*> ents; // all of the entity pointers are stored here, and accessed by index directly
+        EntityGrid grid; // all of the entity indexes are also stored here, by location
+        MovementArrays movement; // the movement state of all of the entities, accessed by index
+        DirtyList dirtyEnts; // the entities that changed since the last commitChanges call
+        EntityAllocator allocator; // all of the entities are allocated from here
+        std::vector <int> freeIndexes; // unused indexes go here, as a min-heap
+        std::vector <sf::Uint8> generations; // the generation of each index, kept even after the list shrinks
+        std::vector <ChangeTicks> changeTicks; // used for finding what changed for each client, accessed by index
+        sf::Uint32 currentTick; // the tick of the last commitChanges call
 };
 
 #endif
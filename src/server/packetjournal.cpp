@@ -0,0 +1,150 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "packetjournal.h"
+#include <cstring>
+#include "packet.h"
+
+PacketJournal::PacketJournal():
+    writing(false),
+    seed(0),
+    ticksRead(0)
+{
+}
+
+bool PacketJournal::openForWriting(const std::string& filename, unsigned newSeed)
+{
+    output.open(filename, std::ios::binary | std::ios::trunc);
+    writing = output.is_open();
+    if (writing)
+    {
+        seed = newSeed;
+        output.write("UMJ", 3);
+        output.put(version);
+        writeUint32(seed);
+        writeUint32(Packet::ProtocolVersion);
+    }
+    return writing;
+}
+
+bool PacketJournal::isWriting() const
+{
+    return writing;
+}
+
+void PacketJournal::writeTick(float seconds)
+{
+    sf::Uint32 bits;
+    std::memcpy(&bits, &seconds, sizeof(bits));
+    output.put(TickEntry);
+    writeUint32(bits);
+}
+
+void PacketJournal::writePacket(int clientId, const void* data, std::size_t size)
+{
+    output.put(PacketEntry);
+    writeUint32(clientId);
+    writeUint32(size);
+    output.write(static_cast<const char*>(data), size);
+}
+
+void PacketJournal::writeDisconnect(int clientId)
+{
+    output.put(DisconnectEntry);
+    writeUint32(clientId);
+}
+
+void PacketJournal::writeAccountCompletions(unsigned count)
+{
+    output.put(AccountEntry);
+    writeUint32(count);
+}
+
+void PacketJournal::flush()
+{
+    if (writing)
+        output.flush();
+}
+
+bool PacketJournal::openForReading(const std::string& filename)
+{
+    ticksRead = 0;
+    input.open(filename, std::ios::binary);
+    char header[4];
+    sf::Uint32 protocolVersion = 0;
+    if (!input.read(header, 4) || std::memcmp(header, "UMJ", 3) != 0 || header[3] != version)
+        return false;
+    sf::Uint32 storedSeed;
+    if (!readUint32(storedSeed) || !readUint32(protocolVersion))
+        return false;
+    seed = storedSeed;
+    // The packets would be decoded differently by another version of the server
+    return (static_cast<int>(protocolVersion) == Packet::ProtocolVersion);
+}
+
+bool PacketJournal::readTick(float& seconds, std::vector<Entry>& entries, unsigned& accountCompletions)
+{
+    entries.clear();
+    accountCompletions = 0;
+    sf::Uint32 bits;
+    if (input.get() != TickEntry || !readUint32(bits))
+        return false;
+    std::memcpy(&seconds, &bits, sizeof(seconds));
+
+    // Everything up to the next tick happened during this one
+    while (input.peek() == PacketEntry || input.peek() == DisconnectEntry || input.peek() == AccountEntry)
+    {
+        if (input.peek() == AccountEntry)
+        {
+            input.get();
+            sf::Uint32 count;
+            if (!readUint32(count))
+                return false;
+            accountCompletions += count;
+            continue;
+        }
+        Entry entry;
+        entry.disconnected = (input.get() == DisconnectEntry);
+        sf::Uint32 clientId;
+        if (!readUint32(clientId))
+            return false;
+        entry.clientId = static_cast<int>(clientId);
+        if (!entry.disconnected)
+        {
+            sf::Uint32 size;
+            if (!readUint32(size))
+                return false;
+            entry.data.resize(size);
+            if (size > 0 && !input.read(entry.data.data(), size))
+                return false;
+        }
+        entries.push_back(std::move(entry));
+    }
+    ++ticksRead;
+    return true;
+}
+
+unsigned PacketJournal::getSeed() const
+{
+    return seed;
+}
+
+unsigned PacketJournal::getTicksRead() const
+{
+    return ticksRead;
+}
+
+void PacketJournal::writeUint32(sf::Uint32 value)
+{
+    char bytes[4] = {char(value), char(value >> 8), char(value >> 16), char(value >> 24)};
+    output.write(bytes, 4);
+}
+
+bool PacketJournal::readUint32(sf::Uint32& value)
+{
+    unsigned char bytes[4];
+    if (!input.read(reinterpret_cast<char*>(bytes), 4))
+        return false;
+    value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<sf::Uint32>(bytes[3]) << 24);
+    return true;
+}
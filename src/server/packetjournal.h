@@ -0,0 +1,80 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef PACKETJOURNAL_H
+#define PACKETJOURNAL_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <SFML/Config.hpp>
+
+/*
+This class records everything that comes in from the clients to a binary file, so the same load can be replayed later.
+The journal is a list of ticks, each with the time it simulated and the packets that were handled during it.
+    Disconnects are also recorded, since they change the game state too.
+    The random seed the server started with is in the header, so the world can be made the same way again.
+The entries are recorded on the main thread in the order they were handled, so a replay handles them in the same ticks.
+Logging in and creating accounts still use the account files during a replay,
+    so a replay should use a copy of the accounts directory from when the journal was started.
+    The account thread can finish a request several ticks after its packet, so the number of requests
+        it finished is recorded with each tick, and a replay finishes them in the same ticks.
+
+File format (all numbers are little endian):
+    Header: "UMJ" and a version byte, then the random seed (Uint32) and the protocol version (Int32)
+    Tick entry: type (Uint8), simulated seconds (float)
+    Packet entry: type (Uint8), client ID (Int32), size (Uint32), then the packet data
+    Disconnect entry: type (Uint8), client ID (Int32)
+    Account entry: type (Uint8), number of account requests finished (Uint32)
+*/
+class PacketJournal
+{
+    public:
+        // A packet or disconnect read from the journal
+        struct Entry
+        {
+            int clientId;
+            bool disconnected; // True if the client disconnected, otherwise this is a packet
+            std::vector<char> data;
+        };
+
+        PacketJournal();
+
+        // Recording
+        bool openForWriting(const std::string&, unsigned); // Filename and random seed
+        bool isWriting() const;
+        void writeTick(float); // Starts a new tick, with the seconds it will simulate
+        void writePacket(int, const void*, std::size_t); // Client ID and the packet data
+        void writeDisconnect(int);
+        void writeAccountCompletions(unsigned); // How many account requests were finished this tick
+        void flush();
+
+        // Replaying
+        bool openForReading(const std::string&);
+        bool readTick(float&, std::vector<Entry>&, unsigned&); // Reads the next tick, its entries, and its account completions
+                                                               // Returns false at the end
+        unsigned getSeed() const;
+        unsigned getTicksRead() const;
+
+    private:
+        enum EntryType
+        {
+            TickEntry = 1,
+            PacketEntry,
+            DisconnectEntry,
+            AccountEntry
+        };
+
+        static const char version = 2;
+
+        void writeUint32(sf::Uint32);
+        bool readUint32(sf::Uint32&);
+
+        std::ofstream output;
+        std::ifstream input;
+        bool writing;
+        unsigned seed;
+        unsigned ticksRead;
+};
+
+#endif
@@ -0,0 +1,103 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "packetpool.h"
+#include <utility>
+
+PacketPool::SharedPacket::SharedPacket():
+    buffer(nullptr)
+{
+}
+
+PacketPool::SharedPacket::SharedPacket(Buffer* buffer):
+    buffer(buffer)
+{
+}
+
+PacketPool::SharedPacket::SharedPacket(const SharedPacket& other):
+    buffer(other.buffer)
+{
+    if (buffer != nullptr)
+        ++buffer->refCount;
+}
+
+PacketPool::SharedPacket::SharedPacket(SharedPacket&& other):
+    buffer(other.buffer)
+{
+    other.buffer = nullptr;
+}
+
+PacketPool::SharedPacket& PacketPool::SharedPacket::operator=(SharedPacket other)
+{
+    std::swap(buffer, other.buffer);
+    return *this;
+}
+
+PacketPool::SharedPacket::~SharedPacket()
+{
+    if (buffer != nullptr && --buffer->refCount == 0)
+        buffer->pool->release(buffer);
+}
+
+sf::Packet& PacketPool::SharedPacket::operator*() const
+{
+    return buffer->packet;
+}
+
+sf::Packet* PacketPool::SharedPacket::operator->() const
+{
+    return &buffer->packet;
+}
+
+PacketPool::SharedPacket::operator bool() const
+{
+    return (buffer != nullptr);
+}
+
+PacketPool::PacketPool(unsigned maxFree):
+    maxFree(maxFree),
+    allocated(0)
+{
+}
+
+PacketPool::SharedPacket PacketPool::take()
+{
+    Buffer* buffer;
+    if (freeBuffers.empty())
+    {
+        buffer = new Buffer;
+        buffer->pool = this;
+        ++allocated;
+    }
+    else
+    {
+        buffer = freeBuffers.back().release();
+        freeBuffers.pop_back();
+    }
+    buffer->refCount = 1;
+    return SharedPacket(buffer);
+}
+
+unsigned PacketPool::getAllocated() const
+{
+    return allocated;
+}
+
+unsigned PacketPool::getFree() const
+{
+    return freeBuffers.size();
+}
+
+void PacketPool::release(Buffer* buffer)
+{
+    if (freeBuffers.size() < maxFree)
+    {
+        buffer->packet.clear();
+        freeBuffers.emplace_back(buffer);
+    }
+    else
+    {
+        delete buffer;
+        --allocated;
+    }
+}
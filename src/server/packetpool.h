@@ -0,0 +1,62 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef PACKETPOOL_H
+#define PACKETPOOL_H
+
+#include <vector>
+#include <memory>
+#include <SFML/Network.hpp>
+
+/*
+This class hands out reference counted packets, so a packet can be serialized once and queued to many clients.
+When the last SharedPacket using a packet goes away, the packet is cleared and goes back into the pool.
+    Clearing a packet keeps its memory, so the packets that get reused don't need to grow again.
+A packet should not be changed after it has been queued, since other clients may be sending the same one.
+This is only used from the main thread, so the reference counts aren't atomic.
+The pool must outlive all of the packets taken from it.
+*/
+class PacketPool
+{
+    struct Buffer;
+
+    public:
+        class SharedPacket
+        {
+            public:
+                SharedPacket();
+                SharedPacket(const SharedPacket& other);
+                SharedPacket(SharedPacket&& other);
+                SharedPacket& operator=(SharedPacket other);
+                ~SharedPacket();
+                sf::Packet& operator*() const;
+                sf::Packet* operator->() const;
+                explicit operator bool() const;
+
+            private:
+                friend class PacketPool;
+                SharedPacket(Buffer* buffer);
+                Buffer* buffer;
+        };
+
+        PacketPool(unsigned maxFree = 1024); // The most unused packets to keep around
+        SharedPacket take(); // Returns an empty packet
+        unsigned getAllocated() const; // The number of packets that have been allocated, including ones in use
+        unsigned getFree() const;
+
+    private:
+        struct Buffer
+        {
+            sf::Packet packet;
+            unsigned refCount;
+            PacketPool* pool;
+        };
+
+        void release(Buffer* buffer);
+
+        std::vector<std::unique_ptr<Buffer>> freeBuffers;
+        unsigned maxFree;
+        unsigned allocated;
+};
+
+#endif
@@ -41,3 +41,22 @@ void PlayerData::saveToConfig(cfg::File& config) const
     config("positionY") = positionY;
     inventory.saveToConfig(config);
 }
+
+bool PlayerData::loadFromPacket(sf::Packet& packet)
+{
+    sf::Uint32 newSalt = 0;
+    sf::Int32 newHealth = 0, newLevel = 0;
+    packet >> username >> passwordHash >> newSalt >> banned >> newHealth >> newLevel >> positionX >> positionY;
+    salt = newSalt;
+    health = newHealth;
+    level = newLevel;
+    inventory.loadFromPacket(packet);
+    return packet;
+}
+
+void PlayerData::saveToPacket(sf::Packet& packet) const
+{
+    packet << username << passwordHash << static_cast<sf::Uint32>(salt) << banned;
+    packet << static_cast<sf::Int32>(health) << static_cast<sf::Int32>(level) << positionX << positionY;
+    inventory.saveToPacket(packet);
+}
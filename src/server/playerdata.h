@@ -24,6 +24,8 @@ class PlayerData
         PlayerData(cfg::File&);
         void loadFromConfig(cfg::File&);
         void saveToConfig(cfg::File&) const;
+        bool loadFromPacket(sf::Packet&); // The binary form used by the account store, returns false if it was cut off
+        void saveToPacket(sf::Packet&) const;
 
         std::string username;
         std::string passwordHash;
@@ -1,7 +1,6 @@
 #include "playermanager.h"
 
-PlayerManager::PlayerManager(net::TcpServer& tcpServer):
-    tcpServer(tcpServer)
+PlayerManager::PlayerManager()
 {
 }
 
@@ -11,29 +10,34 @@ PlayerManager::~PlayerManager()
 
 Player::Player():
     id(-1),
-    playerEid(-1)
+    playerEid(-1),
+    snapshotTimer(0),
+    changes(0)
 {
 }
 
 Player::Player(int id):
     id(id),
-    playerEid(-1)
+    playerEid(-1),
+    snapshotTimer(0),
+    changes(0)
 {
 }
 
 Player::Player(int id, const net::Address& address, EID playerEid):
     id(id),
     address(address),
-    playerEid(playerEid)
+    playerEid(playerEid),
+    snapshotTimer(0),
+    changes(0)
 {
 }
 
-Player& PlayerManager::addPlayer(int id)
+Player& PlayerManager::addPlayer(int id, const sf::IpAddress& ip)
 {
-    //players.emplace(id, id);//, tcpServer.getClientAddress(id), 0);
     auto& player = players[id];
     player.id = id;
-    player.address.ip = tcpServer.getClientAddress(id);
+    player.address.ip = ip;
     return player;
 }
 
@@ -59,8 +63,12 @@ void PlayerManager::removePlayer(int id)
     players.erase(id);
 }
 
-void PlayerManager::send(sf::Packet& packet)
+PlayerManager::PlayerMap::iterator PlayerManager::begin()
 {
-    for (auto& player: players)
-        tcpServer.send(packet, player.first);
+    return players.begin();
+}
+
+PlayerManager::PlayerMap::iterator PlayerManager::end()
+{
+    return players.end();
 }
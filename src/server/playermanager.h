@@ -3,16 +3,25 @@
 
 #include <string>
 #include <map>
-#include "tcpserver.h"
+#include <vector>
 #include "address.h"
 #include "playerdata.h"
 #include "entity.h"
+#include "snapshothistory.h"
+#include "priorityaccumulator.h"
 
 /*
 This class contains all of the temporary things needed for when a client is logged in.
 */
 struct Player
 {
+    // Parts of the player data that can change while the player is logged in
+    enum Changes
+    {
+        PositionChanged = 1,
+        InventoryChanged = 2
+    };
+
     Player();
     Player(int id);
     Player(int id, const net::Address& address, EID playerEid);
@@ -22,6 +31,10 @@ struct Player
 
     EID playerEid; // The entity ID of the player's entity
     PlayerData playerData; // The player's game data
+    SnapshotHistory snapshots; // What was sent to this client, and what it has acknowledged
+    PriorityAccumulator priorities; // Which entities are the most important to send to this client
+    float snapshotTimer; // Seconds since the last entity update was sent to this client
+    unsigned changes; // What changed in the player data since it was last saved
 };
 
 /*
@@ -35,16 +48,16 @@ class PlayerManager
     using PlayerMap = std::map<int, Player>;
 
     public:
-        PlayerManager(net::TcpServer& tcpServer);
+        PlayerManager();
         ~PlayerManager();
-        Player& addPlayer(int id);
+        Player& addPlayer(int id, const sf::IpAddress& ip);
         Player* getPlayer(int id);
         Player* getPlayer(const std::string& username);
         void removePlayer(int id);
-        void send(sf::Packet& packet);
+        PlayerMap::iterator begin();
+        PlayerMap::iterator end();
 
     private:
-        net::TcpServer& tcpServer;
         PlayerMap players;
 };
 
@@ -0,0 +1,35 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "priorityaccumulator.h"
+#include <algorithm>
+
+const float PriorityAccumulator::distanceWeight = 3.0f;
+
+void PriorityAccumulator::clear()
+{
+    priorities.clear();
+}
+
+float PriorityAccumulator::accumulate(int index, float distance, float radius)
+{
+    if (index < 0)
+        return 0;
+    if (index >= (int)priorities.size())
+        priorities.resize(index + 1, 0);
+    // Everything in range gains at least 1, so the staleness always counts
+    float closeness = (radius > 0 ? 1.0f - std::min(distance / radius, 1.0f) : 1.0f);
+    priorities[index] += 1.0f + distanceWeight * closeness;
+    return priorities[index];
+}
+
+void PriorityAccumulator::reset(int index)
+{
+    if (index >= 0 && index < (int)priorities.size())
+        priorities[index] = 0;
+}
+
+float PriorityAccumulator::getPriority(int index) const
+{
+    return (index >= 0 && index < (int)priorities.size() ? priorities[index] : 0);
+}
@@ -0,0 +1,31 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef PRIORITYACCUMULATOR_H
+#define PRIORITYACCUMULATOR_H
+
+#include <vector>
+
+/*
+This class decides which entities are the most important to send to a single client, when they can't all fit.
+Every time an entity has changes that are waiting to be sent, its priority goes up by an amount based on its distance.
+    Closer entities go up faster, but the priority keeps growing for as long as the entity is skipped,
+        so even the furthest entities get sent eventually.
+    Once an entity is sent, its priority goes back to 0.
+*/
+class PriorityAccumulator
+{
+    public:
+        static const float distanceWeight; // How much more the closest entities gain than the furthest ones
+
+        void clear();
+        // These take the index part of the entity ID
+        float accumulate(int, float, float); // Adds to the priority based on the distance and radius, returns the new priority
+        void reset(int); // Call this after the entity is sent
+        float getPriority(int) const;
+
+    private:
+        std::vector<float> priorities; // accessed by entity index
+};
+
+#endif
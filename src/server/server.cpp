@@ -4,31 +4,73 @@
 #include "server.h"
 #include "paths.h"
 #include <functional>
+#include <algorithm>
+#include <ctime>
+#include <climits>
 
 const float Server::desiredFrameTime = 1.0 / 120.0;
 const float Server::frameTimeTolerance = -10.0 / 120.0;
+volatile std::sig_atomic_t Server::stopRequested = 0;
 
 // TODO: Add new server options from GDoc
 const cfg::File::ConfigMap Server::defaultOptions = {
 {"", {
     {"port", cfg::makeOption(1337, 1, 65536)},
     {"map", cfg::makeOption("serverdata/maps/2.map")},
+    {"gridCellSize", cfg::makeOption(256, 32)},
+    {"viewRadius", cfg::makeOption(1200, 1)},
+    {"snapshotRate", cfg::makeOption(20, 1, 120)},
+    {"maxSnapshotSize", cfg::makeOption(1400, 64)},
     {"maxZombies", cfg::makeOption(20, 0)},
+    {"threads", cfg::makeOption(0, 0, 256)},
+    {"profileInterval", cfg::makeOption(60, 0)},
+    {"traceFile", cfg::makeOption("")},
+    {"journalFile", cfg::makeOption("")},
+    {"randomSeed", cfg::makeOption(0, 0)},
     {"showExternalIp", cfg::makeOption(false)},
     {"inventorySize", cfg::makeOption(16, 1, 1000)},
-    {"accountsDirectory", cfg::makeOption("serverdata/accounts/")}
+    {"accountsDirectory", cfg::makeOption("serverdata/accounts/")},
+    {"accountIndexSnapshot", cfg::makeOption(true)},
+    {"accountDurability", cfg::makeOption("flush")},
+    {"logInsPerTick", cfg::makeOption(2, 1)},
+    {"autosaveInterval", cfg::makeOption(60, 0)},
+    {"autosaveBatchSize", cfg::makeOption(8, 1)},
+    {"benchmarkTicks", cfg::makeOption(1200, 1)},
+    {"benchmarkSeed", cfg::makeOption(1, 0)},
+    {"benchmarkZombies", cfg::makeOption(5000, 0)},
+    {"benchmarkPlayers", cfg::makeOption(200, 0)},
+    {"benchmarkItems", cfg::makeOption(1000, 0)}
 }}};
 
-Server::Server():
+// How far account writes go before they count as saved, see AccountStore
+static AccountStore::Durability parseDurability(const std::string& name)
+{
+    if (name == "buffer")
+        return AccountStore::Buffered;
+    if (name == "sync")
+        return AccountStore::Synced;
+    return AccountStore::Flushed;
+}
+
+Server::Server(Mode mode, const std::string& replayFile):
+    mode(mode),
+    elapsedTime(0),
     config(Paths::serverConfigFile, defaultOptions, cfg::File::Warnings || cfg::File::Errors),
-    tcpServer(config("port").toInt()),
-    accounts(config("accountsDirectory").toString()),
-    players(tcpServer)
+    jobs(config("threads").toInt()),
+    profiler(desiredFrameTime, (mode == Normal ? config("profileInterval").toInt() : 0)), // The other modes print one report at the end
+    replayFile(replayFile),
+    accounts(config("accountsDirectory").toString(), mode != Replay, config("accountIndexSnapshot").toBool(), // Replays do the account files in the tick
+             parseDurability(config("accountDurability").toString())),
+    logInTickets(0),
+    replayAccountCompletions(0),
+    logInQueueTimer(0),
+    autosaveTimer(0),
+    tcpServer(config("port").toInt())
 {
     using namespace std::placeholders;
     tcpServer.setConnectedCallback(std::bind(&Server::handleClientConnected, this, _1));
-    tcpServer.setDisconnectedCallback(std::bind(&Server::logOutClient, this, _1));
-    tcpServer.setPacketCallback(std::bind(&Server::processPacket, this, _1, _2));
+    tcpServer.setDisconnectedCallback(std::bind(&Server::handleClientDisconnected, this, _1));
+    tcpServer.setPacketCallback(std::bind(&Server::handlePacket, this, _1, _2));
     setup();
 }
 
@@ -40,14 +82,59 @@ void Server::setup()
 
     if (config("showExternalIp").toBool())
         std::cout << "The server's external IP address is: " << sf::IpAddress::getPublicAddress() << std::endl;
+    std::cout << "Using " << jobs.getThreadCount() << " threads for the game loop.\n";
+
+    std::string traceFile = config("traceFile").toString();
+    if (!traceFile.empty() && tracer.open(traceFile))
+    {
+        tracer.setThreadName("Main");
+        profiler.setTracer(&tracer);
+        std::cout << "Recording a trace to \"" << traceFile << "\".\n";
+    }
+
+    // The same seed and the same packets in the same ticks will always give the same game
+    unsigned seed = config("randomSeed").toInt();
+    if (seed == 0)
+        seed = time(nullptr);
+    if (mode == Replay)
+    {
+        if (journal.openForReading(replayFile))
+        {
+            seed = journal.getSeed();
+            std::cout << "Replaying the packet journal \"" << replayFile << "\".\n";
+        }
+        else
+            std::cout << "Error: Could not read the packet journal \"" << replayFile << "\".\n";
+    }
+    std::string journalFile = config("journalFile").toString();
+    if (mode == Normal && !journalFile.empty() && journal.openForWriting(journalFile, seed))
+        std::cout << "Recording a packet journal to \"" << journalFile << "\".\n";
+    srand(seed);
+    std::cout << "Random seed: " << seed << std::endl;
     std::cout << std::endl;
 
     // Load the map file (in the future this can also be randomly generated)
     tileMap.loadFromFile(config("map").toString());
+    tileMapPacket = packetPool.take();
+    tileMap.saveToPacket(*tileMapPacket);
 
     Entity::setMapSize(tileMap.getWidthPx(), tileMap.getHeightPx());
+    entList.setMapSize(tileMap.getWidthPx(), tileMap.getHeightPx(), config("gridCellSize").toInt());
 
     inventorySize = config("inventorySize").toInt();
+    viewRadius = config("viewRadius").toInt();
+    snapshotTime = 1.0f / config("snapshotRate").toInt();
+    maxSnapshotSize = config("maxSnapshotSize").toInt();
+    offlineBytes = 0;
+    logInsPerTick = config("logInsPerTick").toInt();
+    autosaveInterval = (mode == Benchmark ? 0 : config("autosaveInterval").toInt());
+    autosaveBatchSize = config("autosaveBatchSize").toInt();
+
+    if (mode == Benchmark)
+    {
+        spawnBenchmarkWorld();
+        return;
+    }
 
     // Spawn some test zombies
     int maxZombies = config("maxZombies").toInt();
@@ -60,15 +147,28 @@ void Server::setup()
         zombie->setMoving(true);
         zombie->setSpeed(rand() % 100 + 50);
         //zombie->moveTo(sf::Vector2f(500, 500));
+        entList.updateGrid(zombie);
     }
 }
 
 void Server::start()
 {
+    if (mode == Benchmark)
+    {
+        runBenchmark();
+        return;
+    }
+    if (mode == Replay)
+    {
+        runReplay();
+        return;
+    }
     std::cout << "Running TCP server...\n";
     tcpServer.start();
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
     std::cout << "Main thread started.\n";
-    while (true)
+    while (!stopRequested)
     {
         // Update the current game state, also send some of this info to the clients
         update();
@@ -78,290 +178,639 @@ void Server::start()
 
         // Sleep some if everything is caught up, otherwise skip over this right away
         // (If this is skipped, it means the server is running BELOW the desired FPS)
+        // The profiler already warns about slow ticks, and shows which part of the tick was slow
         float sleepTime = desiredFrameTime - elapsedTime;
         if (sleepTime > frameTimeTolerance)
             sf::sleep(sf::seconds(sleepTime));
-        else if (warningTimer.getElapsedTime().asSeconds() >= 5)
-        {
-            std::cout << "WARNING: Last frame took " << -sleepTime << " seconds too long! FPS: " << 1.0 / elapsedTime << "\n";
-            warningTimer.restart();
-        }
     }
+    std::cout << "Stopping the server...\n";
+    saveAllPlayers(); // The account thread finishes writing these before the server is destroyed
     std::cout << "Main thread finished.\n";
 }
 
 void Server::update()
 {
-    auto lock = tcpServer.getLock();
-    // TODO: Iterate through the entity grid instead
-    entList.update(elapsedTime);
-    sendChangedEntities();
+    profiler.beginTick();
+    if (journal.isWriting())
+        journal.writeTick(elapsedTime);
+    {
+        // The network thread keeps receiving while this runs, anything it decodes now gets handled next tick
+        TickProfiler::Scope scope(profiler, TickProfiler::Commands);
+        processCommands();
+    }
+    {
+        // Logins, new accounts, and saves that the account thread finished since the last tick
+        TickProfiler::Scope scope(profiler, TickProfiler::AccountIo);
+        // Replays finish the same number of requests as the recording did in this tick
+        unsigned delivered = accounts.deliverCompletions(mode == Replay ? replayAccountCompletions : UINT_MAX);
+        if (journal.isWriting() && delivered > 0)
+            journal.writeAccountCompletions(delivered);
+        autosave();
+    }
+    {
+        TickProfiler::Scope scope(profiler, TickProfiler::Logins);
+        admitLogIns();
+    }
+    {
+        TickProfiler::Scope scope(profiler, TickProfiler::EntityUpdate);
+        entList.update(elapsedTime, &jobs);
+    }
+    {
+        TickProfiler::Scope scope(profiler, TickProfiler::Snapshots);
+        sendChangedEntities();
+    }
+    {
+        TickProfiler::Scope scope(profiler, TickProfiler::CleanUp);
+        entList.releaseErased();
+        entList.cleanUp();
+    }
+    {
+        TickProfiler::Scope scope(profiler, TickProfiler::Sending);
+        sendQueuedPackets();
+    }
+    if (profiler.endTick())
+        entList.getAllocator().printStats(std::cout); // Along with the tick report
+
+    if (flushTimer.getElapsedTime().asSeconds() >= 1)
+    {
+        if (tracer.isEnabled())
+            tracer.flush();
+        journal.flush();
+        flushTimer.restart();
+    }
 }
 
 void Server::sendChangedEntities()
 {
-    // Later this will be client-specific as soon as we have spatial partitioning
-    sf::Packet changedEntitiesPacket;
-    if (entList.getChangedEntities(changedEntitiesPacket))
-        tcpServer.send(changedEntitiesPacket);
+    entList.commitChanges();
+    // Each client only gets the entities that are close to their player,
+    // and only what changed since the last snapshot it acknowledged
+    // The clients get updates at the snapshot rate instead of every tick, timed from when they logged in
+    std::vector<Player*> duePlayers;
+    for (auto& playerPair: players)
+    {
+        Player& player = playerPair.second;
+        player.snapshotTimer += elapsedTime;
+        if (player.snapshotTimer < snapshotTime)
+            continue;
+        // Don't try to catch up on missed updates after a slow tick
+        player.snapshotTimer = std::min(player.snapshotTimer - snapshotTime, snapshotTime);
+        duePlayers.push_back(&player);
+    }
+
+    // Each client's update is made by a separate job, since it only changes that client's state
+    // The packets are taken from the pool first, since the pool can only be used from this thread
+    std::vector<PacketPool::SharedPacket> packets;
+    packets.reserve(duePlayers.size());
+    for (unsigned i = 0; i < duePlayers.size(); ++i)
+        packets.push_back(packetPool.take());
+    std::vector<char> written(duePlayers.size(), false);
+    jobs.parallelFor(duePlayers.size(), 1, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            TraceRecorder::Scope traceScope(tracer, "buildSnapshot");
+            Player& player = *duePlayers[i];
+            Entity* playerEnt = entList.find(player.playerEid);
+            if (playerEnt != nullptr)
+            {
+                Snapshot snapshot;
+                snapshot.sequence = player.snapshots.getNextSequence();
+                *packets[i] << Packet::EntityUpdate << snapshot.sequence;
+                if (entList.getChangedEntities(*packets[i], playerEnt->getPos(), viewRadius, player.snapshots, player.priorities, maxSnapshotSize, snapshot))
+                {
+                    player.snapshots.addSnapshot(snapshot);
+                    written[i] = true;
+                }
+            }
+        }
+    });
+    for (unsigned i = 0; i < duePlayers.size(); ++i)
+    {
+        if (written[i])
+            send(packets[i], duePlayers[i]->id);
+    }
 }
 
-void Server::processPacket(sf::Packet& packet, int id)
+void Server::runBenchmark()
 {
-    int type = -1;
-    packet >> type;
-    switch (type)
+    int ticks = config("benchmarkTicks").toInt();
+    std::cout << "Running " << ticks << " benchmark ticks...\n";
+    // Every tick simulates the same amount of time, so the results only depend on the settings and the seed
+    elapsedTime = desiredFrameTime;
+    sf::Clock benchmarkClock;
+    for (int tick = 0; tick < ticks; ++tick)
     {
-        case Packet::Input:
-            processInputPacket(packet, id);
-            break;
-        case Packet::ChatMessage:
-            processChatMessage(packet, id);
-            break;
-        case Packet::LogIn:
-            processLogIn(packet, id);
-            break;
-        case Packet::CreateAccount:
-            processCreateAccount(packet, id);
-            break;
-        default:
-            std::cout << "Error: Unknown received packet type. Type = " << type << std::endl;
-            break;
+        addBenchmarkInput();
+        update();
     }
+    std::cout << "Benchmark finished: ";
+    printOfflineResults(ticks, benchmarkClock.getElapsedTime().asSeconds());
 }
 
-void Server::processInputPacket(sf::Packet& packet, int id)
+void Server::spawnBenchmarkWorld()
 {
-    //cout << "Received input packet from client #" << id << endl;
-    auto sender = players.getPlayer(id);
+    srand(config("benchmarkSeed").toInt());
+    int zombies = config("benchmarkZombies").toInt();
+    int items = config("benchmarkItems").toInt();
+    int playerCount = config("benchmarkPlayers").toInt();
+    std::cout << "Benchmark world: " << zombies << " zombies, " << items << " items, " << playerCount << " players\n";
+
+    // Same as the test zombies, but spread out over the whole map
+    for (int i = 0; i < zombies; ++i)
+    {
+        Entity* zombie = entList.add(Entity::Zombie);
+        zombie->setPos(getRandomPosition());
+        zombie->setAngle(rand() % 360);
+        zombie->setMoving(true);
+        zombie->setSpeed(rand() % 100 + 50);
+        entList.updateGrid(zombie);
+    }
+    for (int i = 0; i < items; ++i)
+    {
+        Entity* item = entList.add(Entity::Item);
+        item->setPos(getRandomPosition());
+        entList.updateGrid(item);
+    }
+
+    // The players get made the same way as a log in, but without any accounts or packets
+    for (int id = 0; id < playerCount; ++id)
+    {
+        Player& player = players.addPlayer(id, sf::IpAddress::LocalHost);
+        player.playerData.username = "benchmark" + std::to_string(id);
+        player.playerData.inventory.setSize(inventorySize);
+        Entity* playerEnt = entList.add(Entity::Player);
+        playerEnt->setPos(getRandomPosition());
+        entList.updateGrid(playerEnt);
+        player.playerEid = playerEnt->getID();
+        // Real players log in at different times, so their entity updates are spread out over the ticks
+        player.snapshotTimer = snapshotTime * (rand() % 100) / 100.0f;
+    }
+}
+
+void Server::addBenchmarkInput()
+{
+    for (auto& playerPair: players)
+    {
+        int id = playerPair.first;
+        Player& player = playerPair.second;
+
+        // The clients acknowledge every update right away, like they would on a fast connection
+        ClientCommand ack(ClientCommand::SnapshotAck, id);
+        ack.sequence = player.snapshots.getNextSequence() - 1;
+        commands.push(std::move(ack));
+
+        // About as often as the real client sends these (the visual angle is limited to 10 per second)
+        int chance = rand() % 120;
+        if (chance < 12)
+        {
+            ClientCommand input(ClientCommand::Input, id);
+            input.code = Packet::InputType::ChangeVisualAngle;
+            input.angle = rand() % 360;
+            commands.push(std::move(input));
+        }
+        else if (chance < 14)
+        {
+            ClientCommand input(ClientCommand::Input, id);
+            input.code = Packet::InputType::StartMoving;
+            input.angle = (rand() % 8) * 45;
+            commands.push(std::move(input));
+        }
+        else if (chance < 15)
+        {
+            ClientCommand input(ClientCommand::Input, id);
+            input.code = Packet::InputType::StopMoving;
+            commands.push(std::move(input));
+        }
+        else if (chance < 16)
+        {
+            ClientCommand input(ClientCommand::Input, id);
+            input.code = Packet::InputType::PickupItem;
+            commands.push(std::move(input));
+        }
+    }
+}
+
+sf::Vector2f Server::getRandomPosition() const
+{
+    return sf::Vector2f(rand() % std::max(tileMap.getWidthPx(), 1u), rand() % std::max(tileMap.getHeightPx(), 1u));
+}
+
+void Server::runReplay()
+{
+    // The packets go through the same path as they would from the network thread, and the ticks simulate the same time
+    sf::Clock replayClock;
+    std::vector<PacketJournal::Entry> entries;
+    while (journal.readTick(elapsedTime, entries, replayAccountCompletions))
+    {
+        for (auto& entry: entries)
+        {
+            if (entry.disconnected)
+                handleClientDisconnected(entry.clientId);
+            else
+            {
+                sf::Packet packet;
+                packet.append(entry.data.data(), entry.data.size());
+                handlePacket(packet, entry.clientId);
+            }
+        }
+        update();
+    }
+    std::cout << "Replay finished: ";
+    printOfflineResults(journal.getTicksRead(), replayClock.getElapsedTime().asSeconds());
+}
+
+void Server::printOfflineResults(unsigned ticks, float seconds)
+{
+    float simulated = (mode == Benchmark ? ticks * desiredFrameTime : 0);
+    std::cout << ticks << " ticks in " << seconds << " s, " << ticks / seconds << " ticks/s";
+    if (simulated > 0)
+        std::cout << " (" << simulated / seconds << "x real time)";
+    std::cout << "\nEntity updates: " << offlineBytes / 1024 << " kB";
+    if (ticks > 0)
+        std::cout << " (" << offlineBytes / ticks << " bytes/tick)";
+    std::cout << "\n";
+    profiler.printReport(std::cout);
+    entList.getAllocator().printStats(std::cout);
+}
+
+void Server::handlePacket(sf::Packet& packet, int id)
+{
+    // This runs on the network thread, so the packet is only decoded here
+    TraceRecorder::Scope traceScope(tracer, "decodePacket");
+    ClientCommand command;
+    bool valid = command.decode(packet, id);
+    if (!valid && !journal.isWriting())
+        return;
+    if (journal.isWriting())
+    {
+        // Invalid packets are recorded too, so a replay gets everything the clients sent
+        if (!valid)
+            command = ClientCommand(ClientCommand::Invalid, id);
+        const char* data = static_cast<const char*>(packet.getData());
+        command.rawPacket.assign(data, data + packet.getDataSize());
+    }
+    if (command.type == ClientCommand::LogIn)
+        command.address = (mode == Replay ? sf::IpAddress::LocalHost : tcpServer.getClientAddress(id));
+    commands.push(std::move(command));
+}
+
+void Server::handleClientConnected(int id)
+{
+    tracer.setThreadName("Network");
+    std::cout << "Client " << id << " connected.\n";
+}
+
+void Server::handleClientDisconnected(int id)
+{
+    // Anything the client sent before disconnecting gets handled first
+    commands.push(ClientCommand(ClientCommand::Disconnected, id));
+}
+
+void Server::send(const PacketPool::SharedPacket& packet, int id)
+{
+    outgoingPackets.emplace_back(packet, id);
+}
+
+void Server::sendQueuedPackets()
+{
+    if (outgoingPackets.empty())
+        return;
+    if (mode != Normal)
+    {
+        // There aren't any real clients, so only count what would have been sent
+        for (auto& outgoing: outgoingPackets)
+            offlineBytes += outgoing.first->getDataSize();
+        outgoingPackets.clear();
+        return;
+    }
+    // The TCP server is only locked while handing it the packets, instead of during the whole tick
+    tracer.begin("waitForNetworkLock");
+    auto lock = tcpServer.getLock();
+    tracer.end("waitForNetworkLock");
+    for (auto& outgoing: outgoingPackets)
+        tcpServer.send(*outgoing.first, outgoing.second);
+    outgoingPackets.clear();
+}
+
+void Server::processCommands()
+{
+    ClientCommand command;
+    while (commands.tryPop(command))
+    {
+        if (journal.isWriting())
+        {
+            if (command.type == ClientCommand::Disconnected)
+                journal.writeDisconnect(command.clientId);
+            else
+                journal.writePacket(command.clientId, command.rawPacket.data(), command.rawPacket.size());
+        }
+        switch (command.type)
+        {
+            case ClientCommand::Disconnected:
+                logOutClient(command.clientId);
+                break;
+            case ClientCommand::Input:
+                processInput(command);
+                break;
+            case ClientCommand::ChatMessage:
+                processChatMessage(command);
+                break;
+            case ClientCommand::SnapshotAck:
+                processSnapshotAck(command);
+                break;
+            case ClientCommand::LogIn:
+                processLogIn(command);
+                break;
+            case ClientCommand::CreateAccount:
+                processCreateAccount(command);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void Server::processSnapshotAck(const ClientCommand& command)
+{
+    // The client applied this update, so later updates can be based on it
+    auto sender = players.getPlayer(command.clientId);
+    if (sender)
+        sender->snapshots.acknowledge(command.sequence);
+}
+
+void Server::processInput(const ClientCommand& command)
+{
+    TraceRecorder::Scope traceScope(tracer, "processInput");
+    auto sender = players.getPlayer(command.clientId);
     if (sender)
     {
         Entity* playerEnt = entList.find(sender->playerEid);
-        int inputCode = -1;
-        packet >> inputCode;
-        switch (inputCode)
+        if (playerEnt == nullptr)
+            return;
+        Inventory& inventory = sender->playerData.inventory;
+        switch (command.code)
         {
             case Packet::InputType::StartMoving:
-            {
-                float angle;
-                if (packet >> angle)
-                {
-                    //cout << "Entity ID: " << playerEnt->getID() << ", Angle: " << angle << ".\n";
-                    playerEnt->setAngle(angle);
-                    playerEnt->setMoving(true);
-                }
-            }
+                playerEnt->setAngle(command.angle);
+                playerEnt->setMoving(true);
                 break;
             case Packet::InputType::StopMoving:
                 playerEnt->setMoving(false);
                 break;
             case Packet::InputType::ChangeVisualAngle:
-            {
-                float angle;
-                if (packet >> angle)
-                    playerEnt->setVisualAngle(angle);
-            }
+                playerEnt->setVisualAngle(command.angle);
                 break;
             case Packet::InputType::UseItem:
-                useItem(packet, sender->playerData.inventory, playerEnt);
+                useItem(command.slot, inventory, playerEnt);
                 break;
             case Packet::InputType::PickupItem:
-                pickupItem(sender->playerData.inventory, playerEnt);
+                if (pickupItem(inventory, playerEnt))
+                    sender->changes |= Player::InventoryChanged;
                 break;
             case Packet::InputType::DropItem:
-                dropItem(packet, sender->playerData.inventory, playerEnt);
+                if (dropItem(command.slot, inventory, playerEnt))
+                    sender->changes |= Player::InventoryChanged;
                 break;
             case Packet::InputType::SwapItem:
-                swapItem(packet, sender->playerData.inventory);
+                if (swapItem(command.slot, command.otherSlot, inventory))
+                    sender->changes |= Player::InventoryChanged;
                 break;
             case Packet::InputType::WieldItem:
-                wieldItem(packet, sender->playerData.inventory, playerEnt);
+                wieldItem(command.slot, command.primary, inventory, playerEnt); // Only changes the entity, which isn't saved
                 break;
             default:
-                std::cout << inputCode << " is an unknown or not yet implemented input type.\n";
                 break;
         }
     }
 }
 
-void Server::useItem(sf::Packet& packet, Inventory& inventory, Entity* playerEnt)
+void Server::useItem(int slotId, Inventory& inventory, Entity* playerEnt)
 {
-    int slotId;
-    if (packet >> slotId)
-    {
-        if (slotId == 0)
-            playerEnt->useItem(); // Use wielded item
-        //else
-            //useItem(inventory.getItem(slotId)); // Use item in inventory
-            // Can we use items directly in the inventory? If so, then we should have wieldable and non-wieldable items.
-    }
+    if (slotId == 0)
+        playerEnt->useItem(); // Use wielded item
+    //else
+        //useItem(inventory.getItem(slotId)); // Use item in inventory
+        // Can we use items directly in the inventory? If so, then we should have wieldable and non-wieldable items.
 }
 
-void Server::pickupItem(Inventory& inventory, Entity* playerEnt)
+bool Server::pickupItem(Inventory& inventory, Entity* playerEnt)
 {
-    Entity* itemToPickup = entList.findCollision(playerEnt); // Find an item you are stepping on
+    Entity* itemToPickup = entList.findCollision(playerEnt, Entity::Item); // Find an item you are stepping on
     if (itemToPickup != nullptr)
     {
         // In the future we could always add an auto-wield option to the client which would get sent with this request.
         // It would check if the item was wieldable, and if so, swap it with your currently wielded item.
         if (inventory.addItem(ItemCode(itemToPickup->getItem(), 1))) // Add the item to your inventory
+        {
             entList.erase(itemToPickup->getID()); // Remove the item from the entity list
+            return true;
+        }
     }
+    return false;
 }
 
-void Server::dropItem(sf::Packet& packet, Inventory& inventory, Entity* playerEnt)
+bool Server::dropItem(int slotId, Inventory& inventory, Entity* playerEnt)
 {
-    int slotId;
-    if (packet >> slotId)
+    const ItemCode& itemToDrop = inventory.getItem(slotId); // Get the item code to drop
+    if (!itemToDrop.isEmpty()) // If the item slot isn't empty
     {
-        const ItemCode& itemToDrop = inventory.getItem(slotId); // Get the item code to drop
-        if (!itemToDrop.isEmpty()) // If the item slot isn't empty
+        if (slotId == 0) // If the item is in slot 0 (the currently wielded slot)
+            playerEnt->removeItem(); // Remove the currently wielded item
+        Entity* itemOnGround = entList.add(Entity::Item); // Add the item to the entity list
+        if (itemOnGround != nullptr)
         {
-            if (slotId == 0) // If the item is in slot 0 (the currently wielded slot)
-                playerEnt->removeItem(); // Remove the currently wielded item
-            Entity* itemOnGround = entList.add(Entity::Item); // Add the item to the entity list
-            if (itemOnGround != nullptr)
-            {
-                // TODO: Make it so entities can be an item code, but only the item entities will have a function with actual code
-                //itemOnGround->attachItem(itemToDrop); // Set the entity's item code
-                inventory.removeItem(slotId); // Remove the item from the inventory
-            }
+            // TODO: Make it so entities can be an item code, but only the item entities will have a function with actual code
+            //itemOnGround->attachItem(itemToDrop); // Set the entity's item code
+            return inventory.removeItem(slotId); // Remove the item from the inventory
         }
     }
+    return false;
 }
 
-void Server::swapItem(sf::Packet& packet, Inventory& inventory)
+bool Server::swapItem(int slotId1, int slotId2, Inventory& inventory)
 {
-    int slotId1, slotId2;
-    if (packet >> slotId1 >> slotId2)
-    {
-        inventory.swapItems(slotId1, slotId2);
-        // May need to re-wield or will the selection boxes also be swapped?
-        // It might be better to have the selection boxes be swapped as well,
-        // so that you don't accidentally wield your items when organizing your inventory.
-    }
+    bool swapped = inventory.swapItems(slotId1, slotId2);
+    // May need to re-wield or will the selection boxes also be swapped?
+    // It might be better to have the selection boxes be swapped as well,
+    // so that you don't accidentally wield your items when organizing your inventory.
+    return swapped;
 }
 
-void Server::wieldItem(sf::Packet& packet, Inventory& inventory, Entity* playerEnt)
+void Server::wieldItem(int slotId, bool primary, Inventory& inventory, Entity* playerEnt)
 {
-    int slotId;
-    bool primary; // left = true, right = false
+    // primary: left = true, right = false
     //bool wieldOrUnwield; // Or do we want this function to toggle?
     // Then we should figure out a way to prevent the client from getting out of sync..
-    if (packet >> slotId >> primary)
-    {
-        // Get the item from the inventory
-        const ItemCode& itemToWield = inventory.getItem(slotId);
-        if (!itemToWield.isEmpty())
-            playerEnt->attachItem(itemToWield.type); // Wield the item
-    }
+    // Get the item from the inventory
+    const ItemCode& itemToWield = inventory.getItem(slotId);
+    if (!itemToWield.isEmpty())
+        playerEnt->attachItem(itemToWield.type); // Wield the item
 }
 
-void Server::processChatMessage(sf::Packet& packet, int id)
+void Server::processChatMessage(const ClientCommand& command)
 {
-    int subType = -1;
-    if (packet >> subType)
+    TraceRecorder::Scope traceScope(tracer, "processChatMessage");
+    auto sender = players.getPlayer(command.clientId);
+    if (sender)
     {
-        auto sender = players.getPlayer(id);
-        if (sender)
+        std::string msg = sender->playerData.username + ": " + command.message;
+        auto packetToSend = packetPool.take();
+        if (command.code == Packet::Chat::Public)
         {
-            std::string msgPrefix = sender->playerData.username + ": ";
-            if (subType == Packet::Chat::Public)
+            std::cout << msg << std::endl;
+            // Relay the message back to everyone else
+            *packetToSend << Packet::ChatMessage << Packet::Chat::Public << msg;
+            send(packetToSend);
+        }
+        else if (command.code == Packet::Chat::Private)
+        {
+            const std::string& username = command.username;
+            auto receiver = players.getPlayer(username);
+            if (receiver)
             {
-                // Process the message
-                std::string msg;
-                if (packet >> msg)
-                {
-                    msg.insert(0, msgPrefix);
-                    std::cout << msg << std::endl;
-                    // Relay the message back to everyone else
-                    sf::Packet packetToSend;
-                    packetToSend << Packet::ChatMessage << Packet::Chat::Public << msg;
-                    tcpServer.send(packetToSend);
-                }
+                std::cout << "Message to " << username << ": " << msg << std::endl;
+
+                // Send the private message
+                *packetToSend << Packet::ChatMessage << Packet::Chat::Private << msg;
+                send(packetToSend, receiver->id);
+
+                // Send a message back to the person who requested to send the message
+                // (The first packet is already queued, so this needs a new one)
+                packetToSend = packetPool.take();
+                msg = "Message to \"" + username + "\" was successfully sent.";
+                *packetToSend << Packet::ChatMessage << Packet::Chat::Server << msg;
+                send(packetToSend, command.clientId);
             }
-            else if (subType == Packet::Chat::Private)
+            else
             {
-                // Process the username
-                std::string username;
-                packet >> username;
-                std::string msg;
-                sf::Packet packetToSend;
-                auto receiver = players.getPlayer(username);
-                if (receiver)
-                {
-                    // Process the message
-                    if (packet >> msg)
-                    {
-                        msg.insert(0, msgPrefix);
-                        std::cout << "Message to " << username << ": " << msg << std::endl;
-
-                        // Send the private message
-                        packetToSend << Packet::ChatMessage << Packet::Chat::Private << msg;
-                        tcpServer.send(packetToSend, receiver->id);
-
-                        // Send a message back to the person who requested to send the message
-                        packetToSend.clear();
-                        msg = "Message to \"" + username + "\" was successfully sent.";
-                        packetToSend << Packet::ChatMessage << Packet::Chat::Server << msg;
-                        tcpServer.send(packetToSend, id);
-                    }
-                }
-                else
-                {
-                    // Send a message back to the person who requested to send the message
-                    msg = "Error sending message to \"" + username + "\".";
-                    packetToSend << Packet::ChatMessage << Packet::Chat::Server << msg;
-                    tcpServer.send(packetToSend, id);
-                }
+                // Send a message back to the person who requested to send the message
+                msg = "Error sending message to \"" + username + "\".";
+                *packetToSend << Packet::ChatMessage << Packet::Chat::Server << msg;
+                send(packetToSend, command.clientId);
             }
         }
     }
 }
 
-void Server::processLogIn(sf::Packet& packet, int id)
+void Server::processLogIn(const ClientCommand& command)
 {
-    int protocolVersion = -1;
-    std::string username, password;
+    TickProfiler::Scope scope(profiler, TickProfiler::Logins);
+    TraceRecorder::Scope traceScope(tracer, "processLogIn");
+    int id = command.clientId;
+    const std::string& username = command.username;
     int loginStatusCode = Packet::LogInCode::UnknownFailure;
 
-    if (packet >> protocolVersion)
+    if (command.protocolVersion == Packet::ProtocolVersion)
     {
-        std::cout << "Packet protocol version extracted.\n";
-        if (protocolVersion == Packet::ProtocolVersion)
+        std::cout << "Packet protocol version is correct.\n";
+        if (command.complete)
         {
-            std::cout << "Packet protocol version is correct.\n";
-            if (packet >> username >> password)
+            std::cout << "Extracted username and password: " << username << ", " << command.password << std::endl;
+            if (!players.getPlayer(username) && !isLogInPending(username)) // Make sure the user is NOT already logged in
             {
-                std::cout << "Extracted username and password: " << username << ", " << password << std::endl;
-                if (!players.getPlayer(username)) // Make sure the user is NOT already logged in
+                std::cout << "User is not already logged in.\n";
+                // The account gets loaded on the account thread, and the rest of the login happens when it's done
+                unsigned ticket = ++logInTickets;
+                pendingLogIns[id] = PendingLogIn{username, ticket};
+                sf::IpAddress address = command.address;
+                accounts.logIn(username, command.password, [this, id, ticket, address](int status, PlayerData& playerData)
                 {
-                    std::cout << "User is not already logged in.\n";
-                    Player& player = players.addPlayer(id);
-                    std::cout << "Added player.\n";
-                    // Try logging into the account database with the received username and password
-                    int dbLogInStatus = accounts.logIn(username, password, player.playerData);
-                    std::cout << "Attempted login to account database.\n";
-                    if (dbLogInStatus == Packet::LogInCode::Successful)
-                    {
-                        loginStatusCode = Packet::LogInCode::Successful; // The player has successfully logged in!
-                        handleSuccessfulLogIn(player); // Do everything that needs to be done for them to be logged in
-                    }
-                    else
-                        loginStatusCode = dbLogInStatus;
-                }
-                else
-                    loginStatusCode = Packet::LogInCode::AlreadyLoggedIn;
+                    finishLogIn(id, ticket, address, status, playerData);
+                });
+                return;
             }
+            else
+                loginStatusCode = Packet::LogInCode::AlreadyLoggedIn;
+        }
+    }
+    else if (command.protocolVersion != -1)
+        loginStatusCode = Packet::LogInCode::ProtocolVersionMismatch;
+
+    sendLogInStatus(id, username, loginStatusCode);
+}
+
+void Server::finishLogIn(int id, unsigned ticket, const sf::IpAddress& address, int status, PlayerData& playerData)
+{
+    TraceRecorder::Scope traceScope(tracer, "finishLogIn");
+    auto found = pendingLogIns.find(id);
+    if (found == pendingLogIns.end() || found->second.ticket != ticket)
+        return; // The client disconnected while its account was loading
+    std::cout << "Attempted login to account database.\n";
+    if (status == Packet::LogInCode::Successful)
+    {
+        // They stay pending until they are let in, so the account can't be logged into again while they wait
+        logInQueue.push_back(QueuedLogIn{id, ticket, address, std::move(playerData), 0});
+        return;
+    }
+    std::string username = found->second.username;
+    pendingLogIns.erase(found);
+    sendLogInStatus(id, username, status);
+}
+
+void Server::admitLogIns()
+{
+    // Only a few players are let in each tick, so when everyone reconnects at once the tick doesn't stall
+    auto isWaiting = [this](const QueuedLogIn& queued)
+    {
+        auto found = pendingLogIns.find(queued.id);
+        return (found != pendingLogIns.end() && found->second.ticket == queued.ticket);
+    };
+    unsigned admitted = 0;
+    while (!logInQueue.empty() && admitted < logInsPerTick)
+    {
+        QueuedLogIn& queued = logInQueue.front();
+        if (isWaiting(queued)) // Otherwise they disconnected while in the queue
+        {
+            // The player has successfully logged in!
+            int id = queued.id;
+            pendingLogIns.erase(id);
+            Player& player = players.addPlayer(id, queued.address);
+            player.playerData = std::move(queued.playerData);
+            handleSuccessfulLogIn(player); // Do everything that needs to be done for them to be logged in
+            sendLogInStatus(id, player.playerData.username, Packet::LogInCode::Successful);
+            ++admitted;
+        }
+        logInQueue.pop_front();
+    }
+
+    // Everyone left gets their place in the queue when they join it, and then about once per second if it changed
+    logInQueueTimer += elapsedTime;
+    bool updatePositions = (logInQueueTimer >= 1);
+    if (updatePositions)
+        logInQueueTimer = 0;
+    logInQueue.erase(std::remove_if(logInQueue.begin(), logInQueue.end(), [&](const QueuedLogIn& queued){ return !isWaiting(queued); }),
+                     logInQueue.end());
+    for (unsigned i = 0; i < logInQueue.size(); ++i)
+    {
+        QueuedLogIn& queued = logInQueue[i];
+        sf::Uint32 position = i + 1;
+        if (queued.sentPosition == 0 || (updatePositions && queued.sentPosition != position))
+        {
+            auto packet = packetPool.take();
+            *packet << Packet::LogInQueue << position;
+            send(packet, queued.id);
+            queued.sentPosition = position;
         }
-        else
-            loginStatusCode = Packet::LogInCode::ProtocolVersionMismatch;
     }
+}
 
+bool Server::isLogInPending(const std::string& username) const
+{
+    for (auto& pending: pendingLogIns)
+    {
+        if (pending.second.username == username)
+            return true;
+    }
+    return false;
+}
+
+void Server::sendLogInStatus(int id, const std::string& username, int loginStatusCode)
+{
     // Send a packet back to the client with their login status
-    sf::Packet loginStatusPacket;
-    loginStatusPacket << Packet::LogInStatus << loginStatusCode;
-    tcpServer.send(loginStatusPacket, id);
+    auto loginStatusPacket = packetPool.take();
+    *loginStatusPacket << Packet::LogInStatus << loginStatusCode;
+    send(loginStatusPacket, id);
 
     if (loginStatusCode == Packet::LogInCode::Successful)
     {
@@ -373,34 +822,43 @@ void Server::processLogIn(sf::Packet& packet, int id)
         std::cout << "Denied login request. Error code = " << loginStatusCode << std::endl;
 }
 
-void Server::processCreateAccount(sf::Packet& packet, int id)
+void Server::processCreateAccount(const ClientCommand& command)
 {
-    int protocolVersion = -1;
+    TickProfiler::Scope scope(profiler, TickProfiler::Logins);
+    TraceRecorder::Scope traceScope(tracer, "processCreateAccount");
     int createAccountStatus = Packet::CreateAccountCode::UnknownFailure;
 
-    if (packet >> protocolVersion)
+    if (command.protocolVersion == Packet::ProtocolVersion)
     {
-        if (protocolVersion == Packet::ProtocolVersion)
-        {
-            PlayerData playerData;
-            packet >> playerData.username >> playerData.passwordHash;
+        PlayerData playerData;
+        playerData.username = command.username;
+        playerData.passwordHash = command.password;
 
-            std::cout << "Create account request: " << playerData.username << ", password: " << playerData.passwordHash << std::endl;
+        std::cout << "Create account request: " << playerData.username << ", password: " << playerData.passwordHash << std::endl;
 
-            if (!playerData.username.empty() && !playerData.passwordHash.empty())
+        if (!playerData.username.empty() && !playerData.passwordHash.empty())
+        {
+            // The account file gets written on the account thread
+            int id = command.clientId;
+            accounts.createAccount(playerData, [this, id](int status)
             {
-                createAccountStatus = accounts.createAccount(playerData);
-
                 // Send a packet back to the client with their create account status
-                sf::Packet statusPacket;
-                statusPacket << Packet::CreateAccountStatus << createAccountStatus;
-                tcpServer.send(statusPacket, id);
-            }
+                auto statusPacket = packetPool.take();
+                *statusPacket << Packet::CreateAccountStatus << status;
+                send(statusPacket, id);
+                printCreateAccountStatus(status);
+            });
+            return;
         }
-        else
-            createAccountStatus = Packet::CreateAccountCode::ProtocolVersionMismatch;
     }
+    else if (command.protocolVersion != -1)
+        createAccountStatus = Packet::CreateAccountCode::ProtocolVersionMismatch;
 
+    printCreateAccountStatus(createAccountStatus);
+}
+
+void Server::printCreateAccountStatus(int createAccountStatus)
+{
     if (createAccountStatus == Packet::CreateAccountCode::Successful)
         std::cout << "Account was successfully created!\n";
     else
@@ -420,55 +878,122 @@ void Server::handleSuccessfulLogIn(Player& player)
     {
         newPlayerId = newPlayer->getID();
         newPlayer->setPos(sf::Vector2f(player.playerData.positionX, player.playerData.positionY));
+        entList.updateGrid(newPlayer);
     }
     std::cout << "New player entity, ID = " << newPlayerId << std::endl;
     player.playerEid = newPlayerId;
     // Send the new player entity ID to the player
-    sf::Packet playerIdPacket;
-    playerIdPacket << Packet::OnSuccessfulLogIn << newPlayerId;
-    tcpServer.send(playerIdPacket, player.id);
-    // Send all of the entities to the player
-    sf::Packet allEntsPacket;
-    if (entList.getAllEntities(allEntsPacket))
-        tcpServer.send(allEntsPacket, player.id);
-    // Send the map to the player
-    sf::Packet tileMapPacket;
-    tileMap.saveToPacket(tileMapPacket);
-    tcpServer.send(tileMapPacket, player.id);
+    auto playerIdPacket = packetPool.take();
+    *playerIdPacket << Packet::OnSuccessfulLogIn << newPlayerId;
+    send(playerIdPacket, player.id);
+    // The entities around the player will be sent on the next update, since the client doesn't know about any yet
+    player.snapshots.clear();
+    player.priorities.clear();
+    player.snapshotTimer = snapshotTime; // Send everything right away
+    // Send the map to the player (every player gets the same packet)
+    send(tileMapPacket, player.id);
     // Send the inventory to the player
-    sf::Packet inventoryPacket;
-    if (player.playerData.inventory.getAllItems(inventoryPacket))
+    auto inventoryPacket = packetPool.take();
+    if (player.playerData.inventory.getAllItems(*inventoryPacket))
     {
         std::cout << "Sending items from inventory...\n";
-        tcpServer.send(inventoryPacket, player.id);
+        send(inventoryPacket, player.id);
     }
     std::cout << "Sent initial packets to " << player.playerData.username << std::endl;
 }
 
-void Server::handleClientConnected(int id)
-{
-    std::cout << "Client " << id << " connected.\n";
-}
-
 void Server::logOutClient(int id)
 {
+    pendingLogIns.erase(id); // In case their account was still loading
     auto player = players.getPlayer(id);
     if (player)
     {
         std::string username = player->playerData.username;
-        // Save the player's position
-        Entity* playerEnt = entList.find(player->playerEid);
-        if (playerEnt != nullptr)
-        {
-            sf::Vector2f pos = playerEnt->getPos(); // Get the position of the player's entity
-            player->playerData.positionX = pos.x;
-            player->playerData.positionY = pos.y;
+        syncPlayerData(*player); // Save the player's position
+        if (entList.find(player->playerEid) != nullptr)
             entList.erase(player->playerEid); // Remove the player's entity
-        }
         //netManager.sendServerChatMessage(player->playerData.username + " has logged out.", player->id);
-        accounts.saveAccount(player->playerData); // Save their account data in the account database
+        accounts.saveAccount(player->playerData); // Save their account data in the account database (on the account thread)
         players.removePlayer(id);
         std::cout << username << " (" << id << ") logged out.\n";
     }
     std::cout << "Client " << id << " disconnected.\n";
 }
+
+bool Server::syncPlayerData(Player& player)
+{
+    Entity* playerEnt = entList.find(player.playerEid);
+    if (playerEnt != nullptr)
+    {
+        sf::Vector2f pos = playerEnt->getPos();
+        if (pos.x != player.playerData.positionX || pos.y != player.playerData.positionY)
+        {
+            player.playerData.positionX = pos.x;
+            player.playerData.positionY = pos.y;
+            player.changes |= Player::PositionChanged;
+        }
+    }
+    return (player.changes != 0);
+}
+
+void Server::autosave()
+{
+    if (autosaveInterval <= 0)
+        return;
+
+    // Every interval, all of the logged in players get checked, but only a few per tick so the saves are spread out
+    autosaveTimer += elapsedTime;
+    if (autosaveQueue.empty())
+    {
+        if (autosaveTimer < autosaveInterval)
+            return;
+        autosaveTimer = 0;
+        for (auto& player: players)
+            autosaveQueue.push_back(player.first);
+    }
+
+    std::vector<AccountDb::SavedAccount> batch;
+    while (!autosaveQueue.empty() && batch.size() < autosaveBatchSize)
+    {
+        auto player = players.getPlayer(autosaveQueue.back());
+        autosaveQueue.pop_back();
+        if (player && syncPlayerData(*player)) // They could have logged out since the pass started
+        {
+            batch.emplace_back();
+            batch.back().username = player->playerData.username;
+            player->playerData.saveToPacket(batch.back().data);
+            player->changes = 0;
+        }
+    }
+    if (!batch.empty())
+        accounts.saveAccounts(std::move(batch)); // Only the serializing is done here, the account thread writes them
+}
+
+void Server::saveAllPlayers()
+{
+    std::vector<Player*> changed;
+    for (auto& player: players)
+    {
+        if (syncPlayerData(player.second))
+            changed.push_back(&player.second);
+    }
+
+    // Everyone gets written in one batch, so the account store only has to commit once
+    std::vector<AccountDb::SavedAccount> batch(changed.size());
+    jobs.parallelFor(changed.size(), 16, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            batch[i].username = changed[i]->playerData.username;
+            changed[i]->playerData.saveToPacket(batch[i].data);
+            changed[i]->changes = 0;
+        }
+    });
+    std::cout << "Saving " << batch.size() << " players...\n";
+    accounts.saveAccounts(std::move(batch));
+}
+
+void Server::handleStopSignal(int)
+{
+    stopRequested = 1;
+}
@@ -5,11 +5,22 @@
 #define SERVER_H
 
 #include <iostream>
+#include <vector>
+#include <map>
+#include <deque>
+#include <utility>
+#include <csignal>
 #include <SFML/Network.hpp>
 #include "packet.h"
+#include "clientcommand.h"
+#include "mpscqueue.h"
+#include "jobsystem.h"
+#include "tickprofiler.h"
+#include "packetjournal.h"
+#include "packetpool.h"
 #include "masterentitylist.h"
-#include "accountdb.h"
-#include "../graphics/tilemap.h"
+#include "accountworker.h"
+#include "tilemap.h"
 #include "configfile.h"
 #include "tcpserver.h"
 #include "playermanager.h"
@@ -17,51 +28,130 @@
 class Server
 {
     public:
-        Server();
+        enum Mode
+        {
+            Normal,
+            Benchmark, // Runs a fixed number of ticks with a synthetic world and clients, without any sockets
+            Replay // Runs the ticks from a packet journal as fast as possible, without any sockets
+        };
+
+        Server(Mode = Normal, const std::string& = ""); // The packet journal file is only used in replay mode
         void start();
 
     private:
         void setup();
         void update();
+
+        // Benchmark mode
+        void runBenchmark();
+        void spawnBenchmarkWorld();
+        void addBenchmarkInput(); // Makes up inputs and acknowledgements as if they came from real clients
+        sf::Vector2f getRandomPosition() const;
+
+        // Replay mode
+        void runReplay();
+        void printOfflineResults(unsigned, float); // Ticks and seconds
         void sendChangedEntities();
+        void send(const PacketPool::SharedPacket& packet, int id = -1); // Queues a packet to be sent at the end of the tick
+        void sendQueuedPackets();
+
+        // Network thread callbacks (these must not touch the game state)
+        void handlePacket(sf::Packet& packet, int id);
+        void handleClientConnected(int id);
+        void handleClientDisconnected(int id);
+
+        // Command handlers (these are called during the tick)
+        void processCommands();
+        void processInput(const ClientCommand& command);
+        void processChatMessage(const ClientCommand& command);
+        void processSnapshotAck(const ClientCommand& command);
+        void processLogIn(const ClientCommand& command);
+        void processCreateAccount(const ClientCommand& command);
 
-        // Packet handlers
-        void processPacket(sf::Packet& packet, int id);
-        void processInputPacket(sf::Packet& packet, int id);
-        void processChatMessage(sf::Packet& packet, int id);
-        void processLogIn(sf::Packet& packet, int id);
-        void processCreateAccount(sf::Packet& packet, int id);
+        // Account functions (the accounts are loaded and saved on the account thread)
+        void finishLogIn(int id, unsigned ticket, const sf::IpAddress& address, int status, PlayerData& playerData);
+        void admitLogIns(); // Lets some of the queued players in, and tells the rest where they are in the queue
+        bool isLogInPending(const std::string& username) const;
+        void sendLogInStatus(int id, const std::string& username, int loginStatusCode);
+        void printCreateAccountStatus(int createAccountStatus);
 
-        // Inventory/item functions
-        void useItem(sf::Packet&, Inventory&, Entity*);
-        void pickupItem(Inventory&, Entity*);
-        void dropItem(sf::Packet&, Inventory&, Entity*);
-        void swapItem(sf::Packet&, Inventory&);
-        void wieldItem(sf::Packet&, Inventory&, Entity*);
+        // Inventory/item functions (the ones that return bool return true if the inventory changed)
+        void useItem(int, Inventory&, Entity*);
+        bool pickupItem(Inventory&, Entity*);
+        bool dropItem(int, Inventory&, Entity*);
+        bool swapItem(int, int, Inventory&);
+        void wieldItem(int, bool, Inventory&, Entity*);
 
         // Other functions
         void handleSuccessfulLogIn(Player& player);
-        void handleClientConnected(int id);
         void logOutClient(int id);
+        bool syncPlayerData(Player& player); // Returns true if the player data needs to be saved
+        void autosave(); // Saves some of the players that changed each tick
+        void saveAllPlayers(); // For when the server stops
+        static void handleStopSignal(int);
+
+        struct PendingLogIn
+        {
+            std::string username;
+            unsigned ticket;
+        };
+
+        // A player whose account is loaded, but who hasn't been let into the game yet
+        struct QueuedLogIn
+        {
+            int id;
+            unsigned ticket;
+            sf::IpAddress address;
+            PlayerData playerData;
+            unsigned sentPosition; // The last queue position sent to the client (0 if none was sent yet)
+        };
 
         static const float desiredFrameTime;
         static const float frameTimeTolerance;
         static const cfg::File::ConfigMap defaultOptions;
+        static volatile std::sig_atomic_t stopRequested; // Set by the signal handler, which can only use a static
 
+        Mode mode;
         float elapsedTime;
-        sf::Clock clock, warningTimer;
+        sf::Clock clock;
         cfg::File config;
+        JobSystem jobs; // Runs the entity update and the client updates across all of the threads
+        TickProfiler profiler;
+        TraceRecorder tracer; // Only records anything if a trace file is set in the config
+        PacketJournal journal; // Records everything from the clients if a journal file is set in the config
+        std::string replayFile;
+        sf::Clock flushTimer; // For the trace and the packet journal
 
         // Networking
         //ServerNetwork netManager;
-        net::TcpServer tcpServer;
-        AccountDb accounts;
+        MpscQueue<ClientCommand> commands; // Decoded packets from the network thread, handled at the start of each tick
+        PacketPool packetPool; // Outgoing packets are serialized once, and reused after they're sent
+        std::vector<std::pair<PacketPool::SharedPacket, int>> outgoingPackets; // Packets and client IDs to send at the end of the tick
+        AccountWorker accounts;
         PlayerManager players;
+        std::map<int, PendingLogIn> pendingLogIns; // Client IDs waiting on their accounts to load
+        unsigned logInTickets; // Tells apart logins from the same client ID
+        unsigned replayAccountCompletions; // Account requests to finish in the current replay tick
+        std::deque<QueuedLogIn> logInQueue; // These are also still in the pending logins, until they are let in
+        unsigned logInsPerTick;
+        float logInQueueTimer; // Seconds since the queue positions were last updated
+        float autosaveInterval; // Seconds between saving everyone that changed (0 to never autosave)
+        unsigned autosaveBatchSize; // The most players to save in one tick
+        float autosaveTimer;
+        std::vector<int> autosaveQueue; // Client IDs left to check in the current autosave
 
         // The instance of the game
         MasterEntityList entList;
         TileMap tileMap;
+        PacketPool::SharedPacket tileMapPacket; // Saved once when the map is loaded, and sent to every player that logs in
         unsigned int inventorySize;
+        float viewRadius; // How far away entities can be from a player to get sent to their client
+        float snapshotTime; // Seconds between entity updates for each client
+        unsigned maxSnapshotSize; // The most bytes of entity updates to send a client at once (removals can go over)
+        unsigned long long offlineBytes; // Bytes that would have been sent to the clients in benchmark and replay modes
+
+        // This is last so that it's destroyed first, since its thread uses the members above until it's stopped
+        net::TcpServer tcpServer;
 };
 
 #endif
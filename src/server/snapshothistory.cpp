@@ -0,0 +1,81 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "snapshothistory.h"
+
+SnapshotEntity::SnapshotEntity(EID id, sf::Uint32 tick):
+    id(id),
+    tick(tick)
+{
+}
+
+Snapshot::Snapshot():
+    sequence(0)
+{
+}
+
+SnapshotHistory::SnapshotHistory():
+    snapshots(historySize),
+    nextSequence(1),
+    baselineSequence(0),
+    hasBaseline(false)
+{
+}
+
+void SnapshotHistory::clear()
+{
+    // The sequence numbers keep going, so that late acknowledgements can't match new snapshots
+    for (auto& snapshot: snapshots)
+    {
+        snapshot.sequence = 0;
+        snapshot.ents.clear();
+    }
+    hasBaseline = false;
+}
+
+sf::Uint32 SnapshotHistory::getNextSequence() const
+{
+    return nextSequence;
+}
+
+void SnapshotHistory::addSnapshot(Snapshot& snapshot)
+{
+    // The baseline is about to be overwritten, so there won't be anything left to compare against
+    if (hasBaseline && nextSequence - baselineSequence >= historySize)
+        hasBaseline = false;
+    Snapshot& stored = snapshots[nextSequence % historySize];
+    stored.sequence = nextSequence;
+    stored.ents.swap(snapshot.ents);
+    snapshot.sequence = nextSequence;
+    ++nextSequence;
+}
+
+bool SnapshotHistory::acknowledge(sf::Uint32 sequence)
+{
+    if (!isStored(sequence))
+        return false;
+    // Acknowledgements can only move the baseline forward
+    if (!hasBaseline || sequence > baselineSequence)
+    {
+        baselineSequence = sequence;
+        hasBaseline = true;
+    }
+    return true;
+}
+
+const Snapshot* SnapshotHistory::getBaseline() const
+{
+    return (hasBaseline ? &snapshots[baselineSequence % historySize] : nullptr);
+}
+
+const Snapshot* SnapshotHistory::getLatest() const
+{
+    sf::Uint32 latestSequence = nextSequence - 1;
+    return (isStored(latestSequence) ? &snapshots[latestSequence % historySize] : nullptr);
+}
+
+bool SnapshotHistory::isStored(sf::Uint32 sequence) const
+{
+    return (sequence > 0 && sequence < nextSequence && nextSequence - sequence <= historySize &&
+        snapshots[sequence % historySize].sequence == sequence);
+}
@@ -0,0 +1,65 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef SNAPSHOTHISTORY_H
+#define SNAPSHOTHISTORY_H
+
+#include <vector>
+#include <SFML/System.hpp>
+#include "entity.h"
+
+// What a client knows about a single entity after receiving a snapshot
+struct SnapshotEntity
+{
+    SnapshotEntity(EID id, sf::Uint32 tick);
+
+    EID id;
+    sf::Uint32 tick; // The client has the state of the entity from this tick
+};
+
+/*
+A snapshot is the set of entities a client will know about after receiving an entity update.
+The entities are sorted by ID, so that snapshots can be compared in a single pass.
+*/
+struct Snapshot
+{
+    Snapshot();
+
+    sf::Uint32 sequence;
+    std::vector<SnapshotEntity> ents;
+};
+
+/*
+This class keeps a small ring of the most recent snapshots sent to a single client.
+The client acknowledges the snapshots it receives, and the newest acknowledged snapshot is the baseline.
+    The next entity update only needs to contain what changed since the baseline.
+    Until the client acknowledges something newer, updates keep being made against the same baseline,
+        so nothing is lost if an update is skipped or arrives late.
+If the client hasn't acknowledged anything (or its acknowledgement is too old), there is no baseline,
+    and the client gets the full state of everything around it.
+The latest snapshot is what the client will have once it receives everything that was sent (TCP is reliable and ordered),
+    so it is used for deciding which entities the client needs to remove.
+*/
+class SnapshotHistory
+{
+    public:
+        static const unsigned historySize = 32;
+
+        SnapshotHistory();
+        void clear(); // Forgets everything, the next update will be a full update
+        sf::Uint32 getNextSequence() const; // The sequence number the next added snapshot will get
+        void addSnapshot(Snapshot&); // Stores a snapshot that was sent (the contents are swapped out)
+        bool acknowledge(sf::Uint32); // Sets the baseline to a received snapshot, returns false if it's unknown
+        const Snapshot* getBaseline() const; // Returns null if there is no baseline
+        const Snapshot* getLatest() const; // Returns null if nothing was sent since the last clear
+
+    private:
+        bool isStored(sf::Uint32) const;
+
+        std::vector<Snapshot> snapshots; // Ring of sent snapshots, accessed by (sequence % historySize)
+        sf::Uint32 nextSequence;
+        sf::Uint32 baselineSequence;
+        bool hasBaseline;
+};
+
+#endif
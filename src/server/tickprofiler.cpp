@@ -0,0 +1,122 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "tickprofiler.h"
+#include <iostream>
+#include <iomanip>
+
+static long long toMicroseconds(TickProfiler::Clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+TickProfiler::Scope::Scope(TickProfiler& profiler, Phase phase):
+    profiler(profiler),
+    phase(phase),
+    start(Clock::now())
+{
+    if (profiler.tracer != nullptr)
+        profiler.tracer->begin(getPhaseName(phase));
+}
+
+TickProfiler::Scope::~Scope()
+{
+    profiler.addTime(phase, toMicroseconds(Clock::now() - start));
+    if (profiler.tracer != nullptr)
+        profiler.tracer->end(getPhaseName(phase));
+}
+
+TickProfiler::TickProfiler(float tickBudget, float reportInterval):
+    tracer(nullptr),
+    budget(tickBudget * 1000000),
+    reportInterval(reportInterval),
+    tickStart(Clock::now()),
+    lastReport(tickStart),
+    lastBreakdown(tickStart - std::chrono::seconds(1)),
+    slowTicks(0)
+{
+    for (auto& tickTime: tickTimes)
+        tickTime.store(0, std::memory_order_relaxed);
+}
+
+void TickProfiler::setTracer(TraceRecorder* newTracer)
+{
+    tracer = newTracer;
+}
+
+void TickProfiler::beginTick()
+{
+    tickStart = Clock::now();
+    if (tracer != nullptr)
+        tracer->begin("Tick");
+}
+
+bool TickProfiler::endTick()
+{
+    if (tracer != nullptr)
+        tracer->end("Tick");
+    Clock::time_point now = Clock::now();
+    long long total = toMicroseconds(now - tickStart);
+    tickHistogram.record(total);
+    if (total > budget)
+    {
+        ++slowTicks;
+        if (now - lastBreakdown >= std::chrono::seconds(1))
+        {
+            printBreakdown(std::cout, total);
+            lastBreakdown = now;
+        }
+    }
+    for (int phase = 0; phase < PhaseCount; ++phase)
+        phaseHistograms[phase].record(tickTimes[phase].exchange(0, std::memory_order_relaxed));
+
+    if (reportInterval > 0 && now - lastReport >= std::chrono::duration<float>(reportInterval))
+    {
+        printReport(std::cout);
+        for (auto& histogram: phaseHistograms)
+            histogram.clear();
+        tickHistogram.clear();
+        slowTicks = 0;
+        lastReport = now;
+        return true;
+    }
+    return false;
+}
+
+void TickProfiler::addTime(Phase phase, long long microseconds)
+{
+    tickTimes[phase].fetch_add(microseconds, std::memory_order_relaxed);
+}
+
+void TickProfiler::printReport(std::ostream& out) const
+{
+    out << "Tick profile: " << tickHistogram.getCount() << " ticks, " << slowTicks << " over budget (times in ms)\n";
+    out << std::fixed << std::setprecision(2);
+    out << "    " << std::left << std::setw(14) << "Phase" << std::right << std::setw(8) << "p50" << std::setw(8) << "p99" << std::setw(8) << "max" << "\n";
+    auto printRow = [&out](const char* name, const LatencyHistogram& histogram)
+    {
+        out << "    " << std::left << std::setw(14) << name << std::right
+            << std::setw(8) << histogram.getPercentile(50) / 1000.0
+            << std::setw(8) << histogram.getPercentile(99) / 1000.0
+            << std::setw(8) << histogram.getMax() / 1000.0 << "\n";
+    };
+    for (int phase = 0; phase < PhaseCount; ++phase)
+        printRow(getPhaseName(static_cast<Phase>(phase)), phaseHistograms[phase]);
+    printRow("Total", tickHistogram);
+    out.unsetf(std::ios::floatfield);
+    out << std::setprecision(6);
+}
+
+const char* TickProfiler::getPhaseName(Phase phase)
+{
+    static const char* names[] = {"Commands", "AccountIo", "Logins", "EntityUpdate", "Snapshots", "CleanUp", "Sending"};
+    return (phase >= 0 && phase < PhaseCount ? names[phase] : "Unknown");
+}
+
+void TickProfiler::printBreakdown(std::ostream& out, long long total) const
+{
+    out << "WARNING: Tick took " << total / 1000.0 << " ms (budget is " << budget / 1000.0 << " ms):";
+    for (int phase = 0; phase < PhaseCount; ++phase)
+        out << " " << getPhaseName(static_cast<Phase>(phase)) << "=" << tickTimes[phase].load(std::memory_order_relaxed) / 1000.0;
+    out << "\n";
+}
@@ -0,0 +1,84 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef TICKPROFILER_H
+#define TICKPROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include "latencyhistogram.h"
+#include "tracerecorder.h"
+
+/*
+This class measures how long each phase of a server tick takes.
+The phases are timed with Scope objects, and the times of each phase are added up over the whole tick.
+    Phases can be nested (like logins while handling the commands), so they don't add up to the total tick time.
+When a tick ends, the time of each phase goes into a histogram for that phase.
+    If the tick went over its budget, the time of every phase is printed, so it's clear which one caused it.
+        (These are limited to one per second, so a server that can't keep up doesn't just print these forever)
+    Every report interval, the percentiles of every phase are printed, and the histograms start over.
+The scopes can be used from any thread.
+If a trace recorder is set, the ticks and phases are also recorded as trace events.
+
+Example usage:
+{
+    TickProfiler::Scope scope(profiler, TickProfiler::EntityUpdate);
+    entList.update(elapsedTime);
+}
+*/
+class TickProfiler
+{
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        enum Phase
+        {
+            Commands, // Handling all of the commands from the clients
+            AccountIo, // Finishing what the account thread did, and queuing autosaves
+            Logins, // Login and create account packets (part of Commands), and letting in the queued players
+            EntityUpdate,
+            Snapshots, // Making and queuing the entity updates for the clients
+            CleanUp, // Freeing erased entities and shrinking the entity list
+            Sending, // Handing the queued packets to the TCP server
+            PhaseCount
+        };
+
+        // Adds the time from when this is made until it is destroyed to a phase
+        class Scope
+        {
+            public:
+                Scope(TickProfiler&, Phase);
+                ~Scope();
+
+            private:
+                TickProfiler& profiler;
+                Phase phase;
+                Clock::time_point start;
+        };
+
+        TickProfiler(float, float); // Tick budget and report interval in seconds (0 to never report)
+        void setTracer(TraceRecorder*); // Null to stop tracing
+        void beginTick();
+        bool endTick(); // Records the tick, and prints a breakdown or report if needed (returns true if it printed a report)
+        void addTime(Phase, long long); // In microseconds
+        void printReport(std::ostream&) const;
+
+        static const char* getPhaseName(Phase);
+
+    private:
+        void printBreakdown(std::ostream&, long long) const;
+
+        TraceRecorder* tracer;
+        long long budget; // In microseconds
+        float reportInterval;
+        Clock::time_point tickStart;
+        Clock::time_point lastReport;
+        Clock::time_point lastBreakdown;
+        std::atomic<long long> tickTimes[PhaseCount]; // The time spent on each phase during the current tick
+        LatencyHistogram phaseHistograms[PhaseCount];
+        LatencyHistogram tickHistogram;
+        unsigned slowTicks; // Since the last report
+};
+
+#endif
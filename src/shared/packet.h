@@ -9,7 +9,7 @@
 namespace Packet
 {
     // This is sent with the login packet
-    const int ProtocolVersion = 8;
+    const int ProtocolVersion = 12;
 
     // This type is sent with every packet so the code that receives it can determine how to process it
     // Please refer to the documentation for more information about these types
@@ -35,8 +35,12 @@ namespace Packet
         CreateAccount,
         GetPlayerList,
         GetServerInfo,
+        SnapshotAck, // The sequence number of the last entity update that was applied
 
-        TotalPacketTypes // For the server
+        TotalPacketTypes, // For the server
+
+        // Client needs to receive these (they're after the others, so older clients still get the same values)
+        LogInQueue // Sent from the server while the client waits to be let in, has its place in the queue (Uint32)
     };
 
     // Sub-types
@@ -83,6 +87,24 @@ namespace Packet
             Private
         };
     }
+    namespace EntityCode
+    {
+        /*
+        Each entity in an entity update starts with its ID (as a variable length integer) and a header byte.
+        The header byte contains the Entity::Field flags of the fields that follow, and these flags:
+        */
+        enum Type
+        {
+            Created = 64, // The client should create the entity if needed, the type (Uint8) comes before the fields
+            Removed = 128 // The client should remove the entity, the reason (Uint8) follows instead of any fields
+        };
+        // The reasons for removing an entity
+        enum Reason
+        {
+            Deleted = 1, // The entity no longer exists
+            OutOfRange // The entity is too far away from the client's player
+        };
+    }
     namespace InputType
     {
         enum Type
@@ -0,0 +1,69 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "packetcodec.h"
+#include <cmath>
+
+namespace PacketCodec
+{
+
+const float positionScale = 8.0f;
+const float angleScale = 65536.0f / 360.0f;
+
+void writeVarInt(sf::Packet& packet, sf::Uint32 value)
+{
+    while (value >= 0x80)
+    {
+        packet << static_cast<sf::Uint8>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    packet << static_cast<sf::Uint8>(value);
+}
+
+bool readVarInt(sf::Packet& packet, sf::Uint32& value)
+{
+    value = 0;
+    sf::Uint8 byte = 0x80;
+    // A 32-bit number never takes more than 5 bytes
+    for (int shift = 0; shift < 35 && (byte & 0x80); shift += 7)
+    {
+        if (!(packet >> byte))
+            return false;
+        value |= static_cast<sf::Uint32>(byte & 0x7F) << shift;
+    }
+    return !(byte & 0x80);
+}
+
+void writePosition(sf::Packet& packet, float value)
+{
+    writeVarInt(packet, value > 0 ? static_cast<sf::Uint32>(value * positionScale + 0.5f) : 0);
+}
+
+bool readPosition(sf::Packet& packet, float& value)
+{
+    sf::Uint32 quantized;
+    bool status = readVarInt(packet, quantized);
+    if (status)
+        value = quantized / positionScale;
+    return status;
+}
+
+void writeAngle(sf::Packet& packet, float degrees)
+{
+    // Wrap the angle into [0, 360) so negative angles work too
+    degrees = std::fmod(degrees, 360.0f);
+    if (degrees < 0)
+        degrees += 360.0f;
+    packet << static_cast<sf::Uint16>(static_cast<sf::Uint32>(degrees * angleScale + 0.5f) & 0xFFFF);
+}
+
+bool readAngle(sf::Packet& packet, float& degrees)
+{
+    sf::Uint16 quantized;
+    bool status = (packet >> quantized);
+    if (status)
+        degrees = quantized / angleScale;
+    return status;
+}
+
+}
@@ -0,0 +1,29 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#ifndef PACKETCODEC_H
+#define PACKETCODEC_H
+
+#include <SFML/Network.hpp>
+
+/*
+These functions write values into packets in a compact form, and read them back out.
+Variable length integers use 7 bits per byte, with the high bit set if there are more bytes.
+    Small numbers like entity IDs usually only take 1 or 2 bytes instead of 4.
+Positions are stored as variable length integers in 1/8ths of a pixel, so they can't be negative.
+Angles are stored in 2 bytes, which is about 0.0055 degrees of precision.
+All of the read functions return false if the packet didn't have enough data.
+*/
+namespace PacketCodec
+{
+    void writeVarInt(sf::Packet& packet, sf::Uint32 value);
+    bool readVarInt(sf::Packet& packet, sf::Uint32& value);
+
+    void writePosition(sf::Packet& packet, float value);
+    bool readPosition(sf::Packet& packet, float& value);
+
+    void writeAngle(sf::Packet& packet, float degrees);
+    bool readAngle(sf::Packet& packet, float& degrees);
+}
+
+#endif
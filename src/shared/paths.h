@@ -28,6 +28,7 @@ namespace Paths
     // Other
     const std::string clientConfigFile = "game.cfg";
     const std::string serverConfigFile = "server.cfg";
+    const std::string loadTestConfigFile = "loadtest.cfg";
     const std::string masterServersConfig = "data/cfg/masterservers.txt";
     const std::string serverListFile = "data/cfg/servers.cfg";  // updated for configFile
     const std::string musicConfigFile = "data/cfg/music.cfg";
@@ -0,0 +1,30 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+#include "tile.h"
+
+Tile::Tile()
+{
+    setID(0);
+}
+
+Tile::Tile(TileID tileID)
+{
+    setID(tileID);
+}
+
+void Tile::setID(TileID tileID)
+{
+    ID = tileID;
+    walkable = (ID < 128);
+}
+
+const TileID Tile::getID() const
+{
+    return ID;
+}
+
+bool Tile::isWalkable() const
+{
+    return walkable;
+}
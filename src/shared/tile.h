@@ -4,32 +4,26 @@
 #ifndef TILE_H
 #define TILE_H
 
-#include <SFML/Graphics.hpp>
-#include "tileset.h"
+#include <SFML/Config.hpp>
 
 typedef sf::Uint16 TileID;
 
-class Tile: public sf::Drawable
+// This only stores the game data of a tile, the graphics are handled by TileMapRenderer on the client
+class Tile
 {
     public:
         Tile();
-        Tile(TileID, int, int);
+        Tile(TileID);
         void setID(TileID);
         const TileID getID() const;
-        void setPos(int, int);
         bool isWalkable() const;
-        void draw(sf::RenderTarget&, sf::RenderStates) const;
 
         static const unsigned int tileWidth = 128;
         static const unsigned int tileHeight = 128;
-        static void loadTextures();
 
     private:
-        static TileSet textures;
-
         TileID ID;
         bool walkable;
-        sf::Sprite sprite;
 };
 
 #endif
@@ -50,13 +50,19 @@ bool TileMap::isReady() const
     return ready;
 }
 
+const Tile& TileMap::getTile(unsigned int x, unsigned int y) const
+{
+    return tiles[y][x];
+}
+
 void TileMap::loadFromMemory(const TileIDVector2D& mapData)
 {
+    tiles.clear();
     tiles.resize(mapData.size());
     for (unsigned int y = 0; y < mapData.size(); y++)
     {
         for (unsigned int x = 0; x < mapData[y].size(); x++)
-            tiles[y].emplace_back(mapData[y][x], x * Tile::tileWidth, y * Tile::tileHeight);
+            tiles[y].emplace_back(mapData[y][x]);
     }
 
     updateMapSize();
@@ -77,13 +83,14 @@ bool TileMap::loadFromFile(const std::string& filename)
     int width, height;
     inFile >> width >> height;
 
+    tiles.clear();
     tiles.resize(height);
     for (int y = 0; y < height; y++)
     {
         for (int x = 0; x < width; x++)
         {
             inFile >> tmpID;
-            tiles[y].emplace_back(tmpID, x * Tile::tileWidth, y * Tile::tileHeight);
+            tiles[y].emplace_back(tmpID);
         }
     }
     inFile.close();
@@ -128,43 +135,6 @@ void TileMap::saveToPacket(sf::Packet& packet) const
     }
 }
 
-void TileMap::draw(sf::RenderTarget& window, sf::RenderStates states) const
-{
-    if (!ready)
-        return;
-
-    // No need to pass the view in separately, it is already stored inside the window
-    sf::View viewWindow = window.getView();
-
-    sf::Vector2f viewSize(viewWindow.getSize());
-    sf::Vector2f viewCenter(viewWindow.getCenter());
-    sf::FloatRect viewRect(viewCenter.x - viewSize.x / 2, viewCenter.y - viewSize.y / 2, viewSize.x, viewSize.y);
-
-    // Convert coordinates of view to logical tile coordinates
-    int startX = viewRect.left / Tile::tileWidth;
-    int startY = viewRect.top / Tile::tileHeight;
-
-    int endX = (viewRect.left + viewRect.width) / Tile::tileWidth + 1;
-    int endY = (viewRect.top + viewRect.height) / Tile::tileHeight + 1;
-
-    // Check if these values are within bounds of the array
-    if (startX < 0)
-        startX = 0;
-    if (startY < 0)
-        startY = 0;
-    if (endX >= (int)tiles.front().size())
-        endX = tiles.front().size() - 1;
-    if (endY >= (int)tiles.size())
-        endY = tiles.size() - 1;
-
-    // Draw all of the tiles within view
-    for (int y = startY; y < endY; y++)
-    {
-        for (int x = startX; x < endX; x++)
-            window.draw(tiles[y][x]);
-    }
-}
-
 void TileMap::updateMapSize()
 {
     mapWidth = tiles.front().size();
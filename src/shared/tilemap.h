@@ -5,17 +5,16 @@
 #define TILEMAP_H
 
 #include <vector>
-#include <SFML/Graphics.hpp>
 #include <SFML/Network.hpp>
 #include "tile.h"
 
 typedef std::vector< std::vector<TileID> > TileIDVector2D;
 typedef std::vector< std::vector<Tile> > TileVector2D;
 
-// This class is used for drawing a graphical tile map
-// TODO: Separate the graphics code so that this can be used on the server without graphics
+// This class stores a tile map, it has no graphics so that it can be used on the server
+// The client draws it with a TileMapRenderer
 // TODO: Make this more generic and flexible so you can use custom tile types and stuff
-class TileMap: public sf::Drawable
+class TileMap
 {
     public:
         TileMap();
@@ -27,11 +26,11 @@ class TileMap: public sf::Drawable
         sf::Uint32 getWidthPx() const;
         sf::Uint32 getHeightPx() const;
         bool isReady() const;
+        const Tile& getTile(unsigned int, unsigned int) const; // Tile coordinates, must be in bounds
         void loadFromMemory(const TileIDVector2D& mapData);
         bool loadFromFile(const std::string&);
         void loadFromPacket(sf::Packet&);
         void saveToPacket(sf::Packet&) const;
-        void draw(sf::RenderTarget&, sf::RenderStates) const;
 
     private:
         void updateMapSize();
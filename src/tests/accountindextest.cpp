@@ -0,0 +1,119 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+#include "accountindex.h"
+
+using namespace std;
+
+int failures = 0;
+
+void check(bool passed, const string& description)
+{
+    cout << (passed ? "Passed: " : "FAILED: ") << description << endl;
+    if (!passed)
+        ++failures;
+}
+
+void writeFile(const string& filename, const string& contents)
+{
+    ofstream out(filename, ios::binary | ios::trunc);
+    out << contents;
+}
+
+string readFile(const string& filename)
+{
+    ifstream in(filename, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+void noTrailingNewlineTest(bool useSnapshot)
+{
+    const string filename = "accountindextest.txt";
+    const string snapshotFilename = (useSnapshot ? "accountindextest.txt.snapshot" : "");
+    remove(filename.c_str());
+    remove("accountindextest.txt.snapshot");
+    writeFile(filename, "first\n1\nsecond\r\n2\r\nlast\n3");
+
+    {
+        AccountIndex index;
+        check(index.loadAccountIndex(filename, snapshotFilename), "Loaded the index");
+        check(index.getAccountCount() == 3, "The last pair is used without a newline");
+        check(index.getAccountId("last") == 3, "The last ID is parsed without a newline");
+        check(index.getAccountId("second") == 2, "CRLF lines are parsed");
+        check(index.addAccount("new") == 4, "A new account doesn't reuse the last ID");
+    }
+    check(readFile(filename) == "first\n1\nsecond\r\n2\r\nlast\n3\nnew\n4\n", "The new account is on its own lines");
+
+    // Loading it again also uses the snapshot (if there is one), and parses what was added after it
+    AccountIndex index;
+    check(index.loadAccountIndex(filename, snapshotFilename), "Loaded the index again");
+    check(index.getAccountCount() == 4, "All of the accounts were loaded again");
+    check(index.getAccountId("last") == 3 && index.getAccountId("new") == 4, "The IDs are the same after loading again");
+    check(index.addAccount("another") == 5, "The next account gets the next ID");
+
+    remove(filename.c_str());
+    remove("accountindextest.txt.snapshot");
+}
+
+void invalidIdTest()
+{
+    const string filename = "accountindextest.txt";
+    writeFile(filename, "good\n1\nbad\n2x\nmissing\n");
+    AccountIndex index;
+    check(index.loadAccountIndex(filename), "Loaded the index");
+    check(index.getAccountId("good") == 1, "A valid pair is used");
+    check(index.getAccountId("bad") == -1, "A pair with an ID that isn't a number is skipped");
+    check(index.getAccountId("missing") == -1, "A username without an ID line is skipped");
+    remove(filename.c_str());
+}
+
+void incompletePairTest(bool useSnapshot)
+{
+    const string filename = "accountindextest.txt";
+    const string snapshotFilename = (useSnapshot ? "accountindextest.txt.snapshot" : "");
+    remove(filename.c_str());
+    remove("accountindextest.txt.snapshot");
+    writeFile(filename, "alice\n1\nbob\n");
+
+    {
+        AccountIndex index;
+        check(index.loadAccountIndex(filename, snapshotFilename), "Loaded an index ending with a username");
+        check(index.getAccountId("bob") == -1, "The username without an ID is skipped");
+        check(index.addAccount("carol") == 2, "The new account gets the next ID");
+    }
+    check(readFile(filename) == "alice\n1\ncarol\n2\n", "The incomplete pair was cut off before adding");
+
+    {
+        AccountIndex index;
+        check(index.loadAccountIndex(filename, snapshotFilename), "Loaded the index again");
+        check(index.getAccountId("alice") == 1, "The first account survived");
+        check(index.getAccountId("carol") == 2, "The new account survived");
+        check(index.addAccount("dave") == 3, "The ID of the new account isn't reused");
+    }
+
+    // A write that was cut off in the middle of the ID ("bob\n12" written as "bob\n1")
+    writeFile(filename, "alice\n1\ncarol\n2\nbob\n1");
+    {
+        AccountIndex index;
+        check(index.loadAccountIndex(filename, snapshotFilename), "Loaded an index with a cut off ID");
+        check(index.getAccountId("bob") == -1, "The cut off ID isn't used");
+        check(index.getAccountId("alice") == 1, "The account with that ID is still the same");
+        check(index.addAccount("erin") == 3, "The next account gets the next ID");
+    }
+    check(readFile(filename) == "alice\n1\ncarol\n2\nerin\n3\n", "The cut off pair was replaced by the new account");
+
+    remove(filename.c_str());
+    remove("accountindextest.txt.snapshot");
+}
+
+int main()
+{
+    noTrailingNewlineTest(false);
+    noTrailingNewlineTest(true);
+    invalidIdTest();
+    incompletePairTest(false);
+    incompletePairTest(true);
+    cout << (failures == 0 ? "All tests passed.\n" : "Some tests failed.\n");
+    return (failures == 0 ? 0 : 1);
+}
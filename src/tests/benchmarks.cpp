@@ -0,0 +1,280 @@
+// See the file COPYRIGHT.txt for authors and copyright information.
+// See the file LICENSE.txt for copying conditions.
+
+/*
+Micro-benchmarks for the containers and codecs that the server uses every tick.
+Usage: benchmarks [output file] [max entities]
+    The results are printed, and also written as CSV (benchmarks.csv by default) so they can be compared between commits.
+    The entity list benchmarks run at every power of 10 from 1000 up to the max entities (1000000 by default).
+    This needs to be run from the root of the repository, so it can find the map files.
+Each row of the CSV file has: benchmark name, size, operations, total milliseconds, nanoseconds per operation
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include "packedarray.h"
+#include "mpscqueue.h"
+#include "csvfile.h"
+#include "masterentitylist.h"
+#include "snapshothistory.h"
+#include "priorityaccumulator.h"
+#include "tilemap.h"
+#include "packet.h"
+
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+void record(const string& name, unsigned size, unsigned long long operations, Clock::duration elapsed);
+void benchmarkPackedArray(unsigned size);
+void benchmarkMpscQueue(unsigned size, unsigned producerCount);
+void benchmarkEntityList(unsigned size);
+void benchmarkTileMap(const string& filename, unsigned repeats);
+void benchmarkEntityData(unsigned repeats);
+
+CsvFile results;
+unsigned long long sink = 0; // Results get added to this so the work can't be optimized away
+
+int main(int argc, char* argv[])
+{
+    string outputFile = (argc > 1 ? argv[1] : "benchmarks.csv");
+    unsigned maxEntities = (argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000000);
+
+    results.addRow().addCell("name").addCell("size").addCell("operations").addCell("ms").addCell("ns/op");
+
+    benchmarkPackedArray(1000000);
+    benchmarkMpscQueue(1000000, 1);
+    benchmarkMpscQueue(1000000, 2);
+    for (unsigned size = 1000; size <= maxEntities; size *= 10)
+        benchmarkEntityList(size);
+    benchmarkTileMap("serverdata/maps/3.map", 100);
+    benchmarkEntityData(1000000);
+
+    if (results.writeToFile(outputFile))
+        cout << "Wrote the results to " << outputFile << ".\n";
+    else
+        cout << "Error writing the results to " << outputFile << ".\n";
+    cout << "(Checksum: " << sink << ")\n";
+    return 0;
+}
+
+void record(const string& name, unsigned size, unsigned long long operations, Clock::duration elapsed)
+{
+    double ms = chrono::duration<double, milli>(elapsed).count();
+    double nsPerOp = (operations > 0 ? ms * 1000000.0 / operations : 0);
+    cout << left << setw(36) << name << right << setw(9) << size << setw(12) << operations;
+    cout << fixed << setprecision(3) << setw(12) << ms << " ms" << setw(12) << nsPerOp << " ns/op\n";
+    cout.unsetf(ios::floatfield);
+    results.addRow().addCell(name).addCell(to_string(size)).addCell(to_string(operations));
+    results.addCell(to_string(ms)).addCell(to_string(nsPerOp));
+}
+
+void benchmarkPackedArray(unsigned size)
+{
+    struct Component
+    {
+        float x, y, speed;
+        int entityId;
+    };
+    PackedArray<Component> components;
+    vector<int> ids(size);
+
+    auto start = Clock::now();
+    for (unsigned i = 0; i < size; ++i)
+        ids[i] = components.push(Component{1.0f, 2.0f, 3.0f, static_cast<int>(i)});
+    record("PackedArray push", size, size, Clock::now() - start);
+
+    start = Clock::now();
+    const unsigned passes = 10;
+    for (unsigned pass = 0; pass < passes; ++pass)
+    {
+        for (auto& component: components)
+            component.x += component.speed;
+    }
+    record("PackedArray iterate", size, size * passes, Clock::now() - start);
+    sink += components[ids[size / 2]].x;
+
+    // Erase in a random order, so the swaps happen all over the array
+    shuffle(ids.begin(), ids.end(), mt19937(1));
+    start = Clock::now();
+    for (int id: ids)
+        components.erase(id);
+    record("PackedArray erase", size, size, Clock::now() - start);
+}
+
+void benchmarkMpscQueue(unsigned size, unsigned producerCount)
+{
+    // More than one producer is like having more than one network thread
+    MpscQueue<int> queue;
+    auto start = Clock::now();
+    vector<thread> producers;
+    for (unsigned p = 0; p < producerCount; ++p)
+    {
+        producers.emplace_back([&]()
+        {
+            for (unsigned i = 0; i < size / producerCount; ++i)
+                queue.push(i);
+        });
+    }
+    unsigned received = 0;
+    unsigned total = (size / producerCount) * producerCount;
+    int value;
+    while (received < total)
+    {
+        if (queue.tryPop(value))
+        {
+            sink += value;
+            ++received;
+        }
+    }
+    for (auto& producer: producers)
+        producer.join();
+    record("MpscQueue " + to_string(producerCount) + " producer(s)/consumer", size, total, Clock::now() - start);
+    cout << "    (" << queue.getCapacity() << " nodes allocated)\n";
+}
+
+void benchmarkEntityList(unsigned size)
+{
+    // The map grows with the entity count, so there are always about as many entities near each client
+    int mapSize = sqrt(size) * 64;
+    Entity::setMapSize(mapSize, mapSize);
+    MasterEntityList entList;
+    entList.setMapSize(mapSize, mapSize);
+    srand(1);
+
+    vector<EID> ids(size);
+    auto start = Clock::now();
+    for (unsigned i = 0; i < size; ++i)
+    {
+        Entity* ent = entList.add(i % 10 == 0 ? Entity::Item : Entity::Zombie);
+        ent->setPos(sf::Vector2f(rand() % mapSize, rand() % mapSize));
+        ent->setAngle(rand() % 360);
+        ent->setMoving(i % 10 != 0);
+        ent->setSpeed(rand() % 100 + 50);
+        entList.updateGrid(ent);
+        ids[i] = ent->getID();
+    }
+    record("MasterEntityList add", size, size, Clock::now() - start);
+
+    const unsigned ticks = 10;
+    start = Clock::now();
+    for (unsigned tick = 0; tick < ticks; ++tick)
+        entList.update(1.0f / 120.0f);
+    record("MasterEntityList update", size, size * ticks, Clock::now() - start);
+
+    // Some clients spread around the map, each getting updates at their own position
+    const unsigned clients = 64;
+    vector<SnapshotHistory> histories(clients);
+    vector<PriorityAccumulator> priorities(clients);
+    vector<sf::Vector2f> positions(clients);
+    for (auto& pos: positions)
+        pos = sf::Vector2f(rand() % mapSize, rand() % mapSize);
+    start = Clock::now();
+    unsigned long long bytes = 0;
+    for (unsigned tick = 0; tick < ticks; ++tick)
+    {
+        entList.update(1.0f / 120.0f);
+        entList.commitChanges();
+        for (unsigned c = 0; c < clients; ++c)
+        {
+            sf::Packet packet;
+            Snapshot snapshot;
+            snapshot.sequence = histories[c].getNextSequence();
+            packet << Packet::EntityUpdate << snapshot.sequence;
+            if (entList.getChangedEntities(packet, positions[c], 1200, histories[c], priorities[c], 1400, snapshot))
+            {
+                histories[c].addSnapshot(snapshot);
+                histories[c].acknowledge(snapshot.sequence);
+            }
+            bytes += packet.getDataSize();
+        }
+    }
+    record("MasterEntityList getChangedEntities", size, clients * ticks, Clock::now() - start);
+    sink += bytes;
+
+    start = Clock::now();
+    for (EID id: ids)
+        entList.erase(id);
+    entList.releaseErased();
+    entList.cleanUp();
+    record("MasterEntityList erase", size, size, Clock::now() - start);
+}
+
+void benchmarkTileMap(const string& filename, unsigned repeats)
+{
+    TileMap tileMap;
+    // Loading the map prints a message every time, so hide those while timing it
+    streambuf* coutBuffer = cout.rdbuf(nullptr);
+    bool loaded = true;
+    auto start = Clock::now();
+    for (unsigned i = 0; i < repeats && loaded; ++i)
+        loaded = tileMap.loadFromFile(filename);
+    auto elapsed = Clock::now() - start;
+    cout.rdbuf(coutBuffer);
+    cout.clear();
+    if (!loaded)
+    {
+        cout << "Error loading " << filename << ", skipping the tile map benchmarks.\n";
+        return;
+    }
+    unsigned tiles = tileMap.getWidth() * tileMap.getHeight();
+    record("TileMap loadFromFile", tiles, repeats, elapsed);
+
+    sf::Packet packet;
+    start = Clock::now();
+    for (unsigned i = 0; i < repeats; ++i)
+    {
+        packet.clear();
+        tileMap.saveToPacket(packet);
+    }
+    record("TileMap saveToPacket", tiles, repeats, Clock::now() - start);
+
+    TileMap received;
+    start = Clock::now();
+    for (unsigned i = 0; i < repeats; ++i)
+    {
+        sf::Packet copy(packet);
+        int type;
+        copy >> type;
+        received.loadFromPacket(copy);
+    }
+    record("TileMap loadFromPacket", tiles, repeats, Clock::now() - start);
+    sink += received.getWidth();
+}
+
+void benchmarkEntityData(unsigned repeats)
+{
+    Entity::setMapSize(100000, 100000);
+    MasterEntityList entList;
+    entList.setMapSize(100000, 100000);
+    const EType types[] = {Entity::Player, Entity::Zombie, Entity::Item};
+    const char* names[] = {"Player", "Zombie", "Item"};
+    for (int t = 0; t < 3; ++t)
+    {
+        Entity* source = entList.add(types[t]);
+        Entity* destination = entList.add(types[t]);
+        source->setPos(sf::Vector2f(1234.5f, 678.9f));
+        source->setAngle(123);
+        source->setSpeed(100);
+        source->setVisualAngle(45);
+        sf::Packet packet;
+        auto start = Clock::now();
+        for (unsigned i = 0; i < repeats; ++i)
+        {
+            packet.clear();
+            source->getData(packet, Entity::AllFields);
+            destination->setData(packet, Entity::AllFields);
+        }
+        record(string(names[t]) + " getData/setData", 1, repeats, Clock::now() - start);
+        sink += destination->getPos().x;
+    }
+}